@@ -0,0 +1,159 @@
+#include "benchmark.h"
+
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counted by every allocation of the benchmark executable
+static std::atomic<uint64_t> allocated_bytes(0);
+static std::atomic<uint64_t> allocation_amount(0);
+
+void* operator new(size_t size)
+{
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    allocation_amount.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = malloc(size ? size : 1);
+    if (!pointer)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+BenchmarkResult runBenchmark(const BenchmarkCase& benchmark_case, double min_seconds, int min_iterations, const std::function<void()>& operation)
+{
+    operation();
+
+    uint64_t bytes_before = allocated_bytes.load(std::memory_order_relaxed);
+    uint64_t allocations_before = allocation_amount.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    long long iterations = 0;
+    double seconds = 0.0;
+    while (iterations < min_iterations || seconds < min_seconds)
+    {
+        operation();
+        iterations++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    uint64_t bytes = allocated_bytes.load(std::memory_order_relaxed) - bytes_before;
+    uint64_t allocations = allocation_amount.load(std::memory_order_relaxed) - allocations_before;
+
+    BenchmarkResult result;
+    result.name = benchmark_case.name;
+    result.backend = benchmark_case.backend;
+    result.frame_width = benchmark_case.frame_width;
+    result.frame_height = benchmark_case.frame_height;
+    result.time_resolution = benchmark_case.time_resolution;
+    result.population_amount = benchmark_case.population_amount;
+    result.iterations = iterations;
+    result.ns_per_op = seconds * 1e9 / iterations;
+    result.evaluations_per_second = benchmark_case.evaluations_per_op * iterations / seconds;
+    result.pixels_per_second = result.evaluations_per_second * benchmark_case.frame_width * benchmark_case.frame_height;
+    result.bytes_allocated_per_op = (double)bytes / iterations;
+    result.allocations_per_op = (double)allocations / iterations;
+    return result;
+}
+
+void printBenchmarkResult(const BenchmarkResult& result, std::ostream& output)
+{
+    std::string label = result.name;
+    if (!result.backend.empty())
+    {
+        label += "/" + result.backend;
+    }
+    if (result.frame_width > 0)
+    {
+        label += "/" + std::to_string(result.frame_width) + "x" + std::to_string(result.frame_height);
+    }
+    if (result.population_amount > 0)
+    {
+        label += "/population:" + std::to_string(result.population_amount);
+    }
+
+    output << std::left << std::setw(48) << label << std::right
+        << std::setw(16) << std::fixed << std::setprecision(0) << result.ns_per_op << " ns/op"
+        << std::setw(14) << std::setprecision(0) << result.bytes_allocated_per_op << " B/op";
+    if (result.evaluations_per_second > 0.0)
+    {
+        output << std::setw(12) << std::setprecision(2) << result.evaluations_per_second << " eval/s"
+            << std::setw(12) << std::setprecision(1) << result.pixels_per_second * 1e-6 << " Mpixel/s";
+    }
+    output << std::defaultfloat << std::endl;
+}
+
+static std::string escapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool writeBenchmarkJson(const std::string& filename, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream output(filename);
+    if (!output.is_open())
+    {
+        std::cerr << "Unable to open benchmark output: " << filename << std::endl;
+        return false;
+    }
+
+#ifdef __OPTIMIZE__
+    bool optimized = true;
+#else
+    bool optimized = false;
+#endif
+
+    output << std::setprecision(17);
+    output << "{\n";
+    output << "  \"compiler\": \"" << escapeJson(__VERSION__) << "\",\n";
+    output << "  \"optimized\": " << (optimized ? "true" : "false") << ",\n";
+    output << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& result = results[i];
+        output << (i == 0 ? "\n" : ",\n");
+        output << "    {\"name\": \"" << escapeJson(result.name) << "\", \"backend\": \"" << escapeJson(result.backend) << "\""
+            << ", \"frame_width\": " << result.frame_width << ", \"frame_height\": " << result.frame_height
+            << ", \"time_resolution\": " << result.time_resolution << ", \"population_amount\": " << result.population_amount
+            << ", \"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.ns_per_op
+            << ", \"evaluations_per_second\": " << result.evaluations_per_second << ", \"pixels_per_second\": " << result.pixels_per_second
+            << ", \"bytes_allocated_per_op\": " << result.bytes_allocated_per_op << ", \"allocations_per_op\": " << result.allocations_per_op << "}";
+    }
+    output << "\n  ]\n}\n";
+    return (bool)output;
+}
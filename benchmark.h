@@ -0,0 +1,55 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+// Timing of one benchmark case. Rates that do not apply to a case are 0.
+struct BenchmarkResult
+{
+    std::string name;
+    std::string backend;
+    int frame_width;
+    int frame_height;
+    int time_resolution;
+    int population_amount;
+
+    long long iterations;
+    double ns_per_op;
+    double evaluations_per_second;
+    // Frame pixels classified per second, frame_width * frame_height per evaluation
+    double pixels_per_second;
+    double bytes_allocated_per_op;
+    double allocations_per_op;
+};
+
+// Describes a case before it runs, the rates are filled from evaluations_per_op
+struct BenchmarkCase
+{
+    std::string name;
+    std::string backend;
+    int frame_width;
+    int frame_height;
+    int time_resolution;
+    int population_amount;
+    // Evaluations one call performs, 0 for cases that evaluate nothing
+    int evaluations_per_op;
+};
+
+// Runs operation once to warm up, then repeatedly until min_seconds have passed
+// and at least min_iterations calls were made. Allocations are counted by the
+// global operator new of the benchmark executable.
+BenchmarkResult runBenchmark(const BenchmarkCase& benchmark_case, double min_seconds, int min_iterations, const std::function<void()>& operation);
+
+void printBenchmarkResult(const BenchmarkResult& result, std::ostream& output);
+// One JSON object with the build and the results, for comparing builds
+bool writeBenchmarkJson(const std::string& filename, const std::vector<BenchmarkResult>& results);
+
+// Keeps the compiler from discarding a result that is otherwise unused
+template <typename T>
+inline void keepResult(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
@@ -0,0 +1,271 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+
+#include <SDL2/SDL.h>
+#include <GL/glew.h>
+
+#include "libs/glm/glm.hpp"
+
+#include "benchmark.h"
+#include "renderer.h"
+#include "cpu_rasterizer.h"
+#include "soft_rasterizer.h"
+#include "optimizer.h"
+#include "rng.h"
+#include "seed_motions.h"
+#include "motion_file.h"
+#include "gl_evaluator.h"
+
+// Fixtures are fixed so that results of different builds are comparable
+const int time_resolution = 1000;
+const int basis_size = 32;
+const uint64_t seed = 1;
+const glm::vec3 anchor = glm::vec3(0.0f, 0.0f, 0.0f);
+
+static std::vector<int> parseResolutions(const std::string& text)
+{
+    std::vector<int> resolutions;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        int resolution = atoi(item.c_str());
+        if (resolution > 0)
+        {
+            resolutions.push_back(resolution);
+        }
+    }
+    return resolutions;
+}
+
+// RGBA frame whose clear color survives in a disk, like a rendered sofa
+static std::vector<GLubyte> buildPixelFixture(int frame_width, int frame_height)
+{
+    std::vector<GLubyte> pixels((size_t)frame_width * frame_height * 4);
+    for (int y = 0; y < frame_height; y++)
+    {
+        for (int x = 0; x < frame_width; x++)
+        {
+            double u = (x + 0.5) / frame_width - 0.5;
+            double v = (y + 0.5) / frame_height - 0.5;
+            bool clear = u * u + v * v < 0.16;
+            GLubyte* pixel = &pixels[((size_t)y * frame_width + x) * 4];
+            pixel[0] = clear ? 255 : 51;
+            pixel[1] = clear ? 255 : 204;
+            pixel[2] = clear ? 255 : 153;
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+// Optimizer whose parents are all scored, so every inflatePopulation breeds a full generation
+static Optimizer buildOptimizerFixture(int population_amount, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence)
+{
+    Optimizer optimizer(time_resolution, yaw_sequence, offset_sequence, population_amount, std::max(1, population_amount * 3 / 10), basis_size, seed);
+    optimizer.inflatePopulation();
+    std::vector<int> scores(population_amount);
+    for (int i = 0; i < population_amount; i++)
+    {
+        scores[i] = 270000 + i;
+    }
+    optimizer.setPopulationScores(scores);
+    optimizer.inflatePopulation();
+    return optimizer;
+}
+
+static bool runGlBenchmarks(const std::vector<int>& resolutions, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence,
+    double min_seconds, std::vector<BenchmarkResult>& results)
+{
+    for (int resolution : resolutions)
+    {
+        GlEvaluatorContext gl;
+        if (!createGlEvaluatorContext("sofa-bench", resolution, resolution, gl))
+        {
+            SDL_Quit();
+            return false;
+        }
+
+        Renderer renderer(resolution, resolution, gl.window, gl.program);
+        BenchmarkCase benchmark_case = { "render", "gl", resolution, resolution, time_resolution, 0, 1 };
+        results.push_back(runBenchmark(benchmark_case, min_seconds, 3, [&]()
+        {
+            keepResult(renderer.Render(time_resolution, anchor, yaw_sequence, offset_sequence));
+        }));
+        printBenchmarkResult(results.back(), std::cout);
+
+        destroyGlEvaluatorContext(gl);
+    }
+
+    SDL_Quit();
+    return true;
+}
+
+// Times the evaluation backends and the optimizer hot paths on fixed fixtures and
+// optionally writes the results as JSON. The GL backend needs a window and only
+// runs with --gl.
+int main(int argc, char* argv[])
+{
+    std::string json_filename;
+    std::string filter;
+    std::string motion_filename;
+    std::vector<int> resolutions = { 350, 700, 1400 };
+    double min_seconds = 1.0;
+    int soft_threads = 1;
+    bool gl = false;
+    for (int a = 1; a < argc; a++)
+    {
+        std::string argument = argv[a];
+        if (argument == "--json" && a + 1 < argc)
+        {
+            json_filename = argv[++a];
+        }
+        else if (argument == "--filter" && a + 1 < argc)
+        {
+            filter = argv[++a];
+        }
+        else if (argument == "--motion" && a + 1 < argc)
+        {
+            motion_filename = argv[++a];
+        }
+        else if (argument == "--resolutions" && a + 1 < argc)
+        {
+            resolutions = parseResolutions(argv[++a]);
+        }
+        else if (argument == "--min-seconds" && a + 1 < argc)
+        {
+            min_seconds = atof(argv[++a]);
+        }
+        else if (argument == "--soft-threads" && a + 1 < argc)
+        {
+            soft_threads = atoi(argv[++a]);
+        }
+        else if (argument == "--gl")
+        {
+            gl = true;
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--json file] [--filter text] [--motion motion.bin] [--resolutions 350,700,1400]"
+                << " [--min-seconds 1.0] [--soft-threads 1] [--gl]" << std::endl;
+            return -1;
+        }
+    }
+
+    // A stored motion if given, Hammersley's sofa otherwise
+    std::vector<double> yaw_sequence;
+    std::vector<glm::vec3> offset_sequence;
+    if (!motion_filename.empty())
+    {
+        if (!loadMotionFile(motion_filename, time_resolution, yaw_sequence, offset_sequence))
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        buildSeedMotion(SEED_MOTION_HAMMERSLEY, time_resolution, yaw_sequence, offset_sequence);
+    }
+
+    std::vector<BenchmarkResult> results;
+    auto selected = [&](const std::string& name)
+    {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    };
+    auto report = [&](const BenchmarkCase& benchmark_case, const std::function<void()>& operation)
+    {
+        results.push_back(runBenchmark(benchmark_case, min_seconds, 3, operation));
+        printBenchmarkResult(results.back(), std::cout);
+    };
+
+    for (int resolution : resolutions)
+    {
+        if (selected("render/cpu"))
+        {
+            CpuRasterizer rasterizer(resolution, resolution);
+            report({ "render", "cpu", resolution, resolution, time_resolution, 0, 1 }, [&]()
+            {
+                keepResult(rasterizer.Render(time_resolution, anchor, yaw_sequence, offset_sequence));
+            });
+        }
+        if (selected("render/soft"))
+        {
+            SoftRasterizer rasterizer(resolution, resolution, soft_threads);
+            report({ "render", "soft", resolution, resolution, time_resolution, 0, 1 }, [&]()
+            {
+                keepResult(rasterizer.Render(time_resolution, anchor, yaw_sequence, offset_sequence));
+            });
+        }
+        if (selected("count_clear_pixels"))
+        {
+            std::vector<GLubyte> pixels = buildPixelFixture(resolution, resolution);
+            report({ "count_clear_pixels", "", resolution, resolution, 0, 0, 1 }, [&]()
+            {
+                keepResult(countClearColorPixels(pixels.data(), resolution * resolution));
+            });
+        }
+    }
+
+    for (int population_amount : { 10, 100 })
+    {
+        if (!selected("optimizer/add_noise_to_yaw") && !selected("optimizer/add_noise_to_offset")
+            && !selected("optimizer/inflate_population") && !selected("optimizer/load_population"))
+        {
+            break;
+        }
+        Optimizer optimizer = buildOptimizerFixture(population_amount, yaw_sequence, offset_sequence);
+
+        // The noise operators are timed on the raw samples, the heaviest case
+        uint32_t individual = 0;
+        if (population_amount == 10 && selected("optimizer/add_noise_to_yaw"))
+        {
+            report({ "optimizer/add_noise_to_yaw", "", 0, 0, time_resolution, 0, 0 }, [&]()
+            {
+                RngStream stream(seed, 0, individual++, RNG_PURPOSE_YAW);
+                GaussianBump bump;
+                keepResult(optimizer.addNoiseToYaw(yaw_sequence, stream, bump));
+            });
+        }
+        if (population_amount == 10 && selected("optimizer/add_noise_to_offset"))
+        {
+            report({ "optimizer/add_noise_to_offset", "", 0, 0, time_resolution, 0, 0 }, [&]()
+            {
+                RngStream stream(seed, 0, individual++, RNG_PURPOSE_OFFSET);
+                GaussianBump bump_x;
+                GaussianBump bump_y;
+                keepResult(optimizer.addNoiseToOffset(offset_sequence, stream, bump_x, bump_y));
+            });
+        }
+        if (selected("optimizer/inflate_population"))
+        {
+            report({ "optimizer/inflate_population", "", 0, 0, time_resolution, population_amount, 0 }, [&]()
+            {
+                optimizer.inflatePopulation();
+            });
+        }
+        if (selected("optimizer/load_population"))
+        {
+            std::vector<std::vector<double>> yaws;
+            std::vector<std::vector<glm::vec3>> offsets;
+            report({ "optimizer/load_population", "", 0, 0, time_resolution, population_amount, 0 }, [&]()
+            {
+                optimizer.loadPopulation(yaws, offsets);
+                keepResult(yaws);
+            });
+        }
+    }
+
+    if (gl && selected("render/gl") && !runGlBenchmarks(resolutions, yaw_sequence, offset_sequence, min_seconds, results))
+    {
+        return -1;
+    }
+
+    if (!json_filename.empty() && !writeBenchmarkJson(json_filename, results))
+    {
+        return -1;
+    }
+    return 0;
+}
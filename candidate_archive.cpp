@@ -0,0 +1,531 @@
+#include "candidate_archive.h"
+#include "optimizer.h"
+
+#include <cstring>
+#include <cmath>
+#include <unistd.h>
+
+static const char archive_magic[8] = { 'S', 'O', 'F', 'A', 'A', 'R', 'C', 'V' };
+static const uint32_t archive_version = 1;
+static const uint32_t chunk_magic = 0x4b484341;
+// Far above what chunk_size records take, anything longer is damage
+static const uint32_t max_chunk_length = 1 << 30;
+
+struct ArchiveHeader
+{
+    char magic[8];
+    uint32_t version;
+    int32_t time_resolution;
+    int32_t basis_size;
+    uint32_t reserved;
+};
+
+struct ChunkHeader
+{
+    uint32_t magic;
+    uint32_t record_amount;
+    uint32_t length;
+    uint32_t crc;
+};
+
+CandidateArchive::CandidateArchive(int time_resolution, int basis_size, size_t chunk_size)
+: time_resolution(time_resolution), basis_size(basis_size), chunk_size(std::max<size_t>(chunk_size, 1)), file(nullptr), largest_id(0), basis(basis_size, time_resolution)
+{
+
+}
+
+CandidateArchive::~CandidateArchive()
+{
+    close();
+}
+
+bool CandidateArchive::writeHeader()
+{
+    ArchiveHeader header;
+    memcpy(header.magic, archive_magic, sizeof(archive_magic));
+    header.version = archive_version;
+    header.time_resolution = time_resolution;
+    header.basis_size = basis_size;
+    header.reserved = 0;
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool CandidateArchive::readHeader(FILE* input)
+{
+    ArchiveHeader header;
+    if (fread(&header, sizeof(header), 1, input) != 1 || memcmp(header.magic, archive_magic, sizeof(archive_magic)) != 0 || header.version != archive_version)
+    {
+        std::cerr << "Not a candidate archive of this version" << std::endl;
+        return false;
+    }
+    if (header.time_resolution != time_resolution || header.basis_size != basis_size)
+    {
+        std::cerr << "Candidate archive was written with time resolution " << header.time_resolution << " and basis size " << header.basis_size << std::endl;
+        return false;
+    }
+    return true;
+}
+
+long CandidateArchive::readChunks(FILE* input, std::vector<ArchiveRecord>* decoded)
+{
+    long good_offset = ftell(input);
+    std::vector<char> bytes;
+    while (true)
+    {
+        ChunkHeader header;
+        if (fread(&header, sizeof(header), 1, input) != 1 || header.magic != chunk_magic || header.length > max_chunk_length)
+        {
+            break;
+        }
+        bytes.resize(header.length);
+        if (fread(bytes.data(), 1, bytes.size(), input) != bytes.size() || computeCrc32(bytes.data(), bytes.size()) != header.crc)
+        {
+            break;
+        }
+        ByteReader reader(bytes);
+        std::vector<ArchiveRecord> chunk_records;
+        if (!decodeChunk(reader, header.record_amount, chunk_records))
+        {
+            break;
+        }
+        for (ArchiveRecord& record : chunk_records)
+        {
+            largest_id = std::max(largest_id, record.id);
+            if (decoded)
+            {
+                decoded->push_back(std::move(record));
+            }
+        }
+        good_offset = ftell(input);
+    }
+    return good_offset;
+}
+
+bool CandidateArchive::openForAppend(const std::string& filename)
+{
+    close();
+    largest_id = 0;
+
+    FILE* input = fopen(filename.c_str(), "rb");
+    if (input)
+    {
+        if (!readHeader(input))
+        {
+            fclose(input);
+            return false;
+        }
+        long good_offset = readChunks(input, nullptr);
+        fseek(input, 0, SEEK_END);
+        long size = ftell(input);
+        fclose(input);
+
+        // A chunk cut short by a crash would hide everything appended after it
+        if (size > good_offset)
+        {
+            std::cerr << "Dropping " << size - good_offset << " damaged bytes at the end of " << filename << std::endl;
+            if (truncate(filename.c_str(), good_offset) != 0)
+            {
+                std::cerr << "Unable to truncate candidate archive: " << filename << std::endl;
+                return false;
+            }
+        }
+
+        file = fopen(filename.c_str(), "ab");
+        if (!file)
+        {
+            std::cerr << "Unable to open candidate archive for appending: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    file = fopen(filename.c_str(), "wb");
+    if (!file || !writeHeader())
+    {
+        std::cerr << "Unable to create candidate archive: " << filename << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void CandidateArchive::record(const Individual& individual, int generation, int fidelity, double seconds)
+{
+    if (!file)
+    {
+        return;
+    }
+
+    largest_id = std::max(largest_id, individual.id);
+    ArchiveRecord record;
+    record.id = individual.id;
+    record.parent_id = individual.parent_id;
+    record.partner_id = individual.partner_id;
+    record.generation = generation;
+    record.score = individual.score;
+    record.fidelity = fidelity;
+    record.seconds = (float)seconds;
+    record.yaw_bump = individual.yaw_bump;
+    record.x_bump = individual.x_bump;
+    record.y_bump = individual.y_bump;
+    record.crossover = individual.crossover;
+    record.blend_width = individual.blend_width;
+    if (record.parent_id == 0)
+    {
+        record.yaw_values = basis_size > 0 ? individual.motion.yaw_controls : individual.yaw_sequence;
+        record.offset_values = basis_size > 0 ? individual.motion.offset_controls : individual.offset_sequence;
+    }
+    pending.push_back(record);
+
+    if (pending.size() >= chunk_size)
+    {
+        flush();
+    }
+}
+
+static void writeBumpColumn(ByteWriter& writer, const std::vector<ArchiveRecord>& records, GaussianBump ArchiveRecord::* bump)
+{
+    for (const ArchiveRecord& record : records)
+    {
+        if (record.parent_id != 0)
+        {
+            writer.write<float>((float)(record.*bump).mean);
+            writer.write<float>((float)(record.*bump).stddev);
+            writer.write<float>((float)(record.*bump).multiplier);
+        }
+    }
+}
+
+static void readBumpColumn(ByteReader& reader, std::vector<ArchiveRecord>& records, size_t first, GaussianBump ArchiveRecord::* bump)
+{
+    for (size_t i = first; i < records.size(); i++)
+    {
+        if (records[i].parent_id != 0)
+        {
+            float values[3] = { 0.0f, 0.0f, 0.0f };
+            reader.read(values);
+            records[i].*bump = { values[0], values[1], values[2] };
+        }
+    }
+}
+
+void CandidateArchive::encodeChunk(ByteWriter& writer)
+{
+    // Lineage, ids are close to the previous record and parents are close to their children
+    int64_t previous_id = 0;
+    for (const ArchiveRecord& record : pending)
+    {
+        writer.writeSignedVarint((int64_t)record.id - previous_id);
+        previous_id = (int64_t)record.id;
+    }
+    for (const ArchiveRecord& record : pending)
+    {
+        writer.writeVarint(record.parent_id != 0 ? record.id - record.parent_id : 0);
+    }
+    for (const ArchiveRecord& record : pending)
+    {
+        writer.writeVarint(record.partner_id != 0 ? record.id - record.partner_id : 0);
+    }
+
+    // Evaluation
+    int64_t previous_generation = 0;
+    int64_t previous_score = 0;
+    for (const ArchiveRecord& record : pending)
+    {
+        writer.writeSignedVarint(record.generation - previous_generation);
+        previous_generation = record.generation;
+    }
+    for (const ArchiveRecord& record : pending)
+    {
+        writer.writeSignedVarint(record.score - previous_score);
+        previous_score = record.score;
+    }
+    for (const ArchiveRecord& record : pending)
+    {
+        writer.writeVarint(record.fidelity);
+    }
+    for (const ArchiveRecord& record : pending)
+    {
+        writer.writeVarint((uint64_t)llround(std::max(record.seconds, 0.0f) * 1e6));
+    }
+
+    // Mutation parameters, only of records with a parent
+    writeBumpColumn(writer, pending, &ArchiveRecord::yaw_bump);
+    writeBumpColumn(writer, pending, &ArchiveRecord::x_bump);
+    writeBumpColumn(writer, pending, &ArchiveRecord::y_bump);
+    for (const ArchiveRecord& record : pending)
+    {
+        if (record.parent_id != 0 && record.partner_id != 0)
+        {
+            writer.write<float>((float)record.crossover);
+            writer.write<float>((float)record.blend_width);
+        }
+    }
+
+    // Whole motions of records without a parent, the offsets without their zero z
+    for (const ArchiveRecord& record : pending)
+    {
+        if (record.parent_id == 0)
+        {
+            writer.writeVarint(record.yaw_values.size());
+            for (double yaw : record.yaw_values)
+            {
+                writer.write(yaw);
+            }
+            writer.writeVarint(record.offset_values.size());
+            for (const glm::vec3& offset : record.offset_values)
+            {
+                writer.write(offset.x);
+                writer.write(offset.y);
+            }
+        }
+    }
+}
+
+bool CandidateArchive::decodeChunk(ByteReader& reader, uint32_t record_amount, std::vector<ArchiveRecord>& decoded)
+{
+    size_t first = decoded.size();
+    decoded.resize(first + record_amount, ArchiveRecord());
+    std::vector<ArchiveRecord>::iterator begin = decoded.begin() + first;
+
+    int64_t value = 0;
+    uint64_t unsigned_value = 0;
+    int64_t previous_id = 0;
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        reader.readSignedVarint(value);
+        previous_id += value;
+        record->id = (uint64_t)previous_id;
+    }
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        reader.readVarint(unsigned_value);
+        record->parent_id = unsigned_value != 0 ? record->id - unsigned_value : 0;
+    }
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        reader.readVarint(unsigned_value);
+        record->partner_id = unsigned_value != 0 ? record->id - unsigned_value : 0;
+    }
+
+    int64_t previous_generation = 0;
+    int64_t previous_score = 0;
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        reader.readSignedVarint(value);
+        previous_generation += value;
+        record->generation = (int32_t)previous_generation;
+    }
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        reader.readSignedVarint(value);
+        previous_score += value;
+        record->score = (int32_t)previous_score;
+    }
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        reader.readVarint(unsigned_value);
+        record->fidelity = (int32_t)unsigned_value;
+    }
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        reader.readVarint(unsigned_value);
+        record->seconds = (float)(unsigned_value * 1e-6);
+    }
+
+    readBumpColumn(reader, decoded, first, &ArchiveRecord::yaw_bump);
+    readBumpColumn(reader, decoded, first, &ArchiveRecord::x_bump);
+    readBumpColumn(reader, decoded, first, &ArchiveRecord::y_bump);
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        if (record->parent_id != 0 && record->partner_id != 0)
+        {
+            float window[2] = { 0.0f, 0.0f };
+            reader.read(window);
+            record->crossover = window[0];
+            record->blend_width = window[1];
+        }
+    }
+
+    for (auto record = begin; record != decoded.end(); ++record)
+    {
+        if (record->parent_id == 0)
+        {
+            uint64_t amount = 0;
+            reader.readVarint(amount);
+            if (amount > (uint64_t)time_resolution || reader.getRemaining() < amount * sizeof(double))
+            {
+                return false;
+            }
+            record->yaw_values.resize(amount);
+            for (double& yaw : record->yaw_values)
+            {
+                reader.read(yaw);
+            }
+            reader.readVarint(amount);
+            if (amount > (uint64_t)time_resolution || reader.getRemaining() < amount * 2 * sizeof(float))
+            {
+                return false;
+            }
+            record->offset_values.assign(amount, glm::vec3(0.0f));
+            for (glm::vec3& offset : record->offset_values)
+            {
+                reader.read(offset.x);
+                reader.read(offset.y);
+            }
+        }
+    }
+
+    return !reader.hasFailed() && reader.getRemaining() == 0;
+}
+
+bool CandidateArchive::flush()
+{
+    if (!file || pending.empty())
+    {
+        return true;
+    }
+
+    ByteWriter writer;
+    encodeChunk(writer);
+
+    ChunkHeader header;
+    header.magic = chunk_magic;
+    header.record_amount = (uint32_t)pending.size();
+    header.length = (uint32_t)writer.getBytes().size();
+    header.crc = computeCrc32(writer.getBytes().data(), writer.getBytes().size());
+    pending.clear();
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(writer.getBytes().data(), 1, writer.getBytes().size(), file) == writer.getBytes().size()
+        && fflush(file) == 0;
+    if (!written)
+    {
+        std::cerr << "Unable to write candidate archive chunk" << std::endl;
+    }
+    return written;
+}
+
+void CandidateArchive::close()
+{
+    if (file)
+    {
+        flush();
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+bool CandidateArchive::load(const std::string& filename)
+{
+    FILE* input = fopen(filename.c_str(), "rb");
+    if (!input)
+    {
+        std::cerr << "Unable to open candidate archive: " << filename << std::endl;
+        return false;
+    }
+    if (!readHeader(input))
+    {
+        fclose(input);
+        return false;
+    }
+
+    records.clear();
+    largest_id = 0;
+    readChunks(input, &records);
+    fclose(input);
+
+    // Ids are unique across runs, a record is only written twice if its candidate was scored twice
+    record_index.clear();
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        record_index[records[i].id] = i;
+    }
+    return true;
+}
+
+uint64_t CandidateArchive::getNextId()
+{
+    return largest_id + 1;
+}
+
+const std::vector<ArchiveRecord>& CandidateArchive::getRecords()
+{
+    return records;
+}
+
+bool CandidateArchive::reconstruct(uint64_t id, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence)
+{
+    // Motions of the ancestors, built from the oldest one without a parent forward
+    std::unordered_map<uint64_t, std::pair<std::vector<double>, std::vector<glm::vec3>>> built;
+    std::vector<uint64_t> stack(1, id);
+    while (!stack.empty())
+    {
+        uint64_t current = stack.back();
+        if (built.count(current))
+        {
+            stack.pop_back();
+            continue;
+        }
+        auto found = record_index.find(current);
+        if (found == record_index.end())
+        {
+            std::cerr << "Candidate " << current << " is not in the archive" << std::endl;
+            return false;
+        }
+        const ArchiveRecord& record = records[found->second];
+        if (record.parent_id == 0)
+        {
+            built[current] = std::make_pair(record.yaw_values, record.offset_values);
+            stack.pop_back();
+            continue;
+        }
+
+        // Parents always have smaller ids, which also rules out cycles
+        bool waiting = false;
+        uint64_t ancestors[2] = { record.parent_id, record.partner_id };
+        for (uint64_t ancestor : ancestors)
+        {
+            if (ancestor == 0 || built.count(ancestor))
+            {
+                continue;
+            }
+            if (ancestor >= current)
+            {
+                std::cerr << "Candidate archive lineage of " << current << " is damaged" << std::endl;
+                return false;
+            }
+            stack.push_back(ancestor);
+            waiting = true;
+        }
+        if (waiting)
+        {
+            continue;
+        }
+
+        std::pair<std::vector<double>, std::vector<glm::vec3>> values = built[record.parent_id];
+        if (record.partner_id != 0)
+        {
+            const std::pair<std::vector<double>, std::vector<glm::vec3>>& partner = built[record.partner_id];
+            values.first = blendSequences(values.first, partner.first, record.crossover, record.blend_width);
+            values.second = blendSequences(values.second, partner.second, record.crossover, record.blend_width);
+        }
+        applyYawBump(values.first, record.yaw_bump);
+        applyOffsetBumps(values.second, record.x_bump, record.y_bump);
+        built[current] = values;
+        stack.pop_back();
+    }
+
+    const std::pair<std::vector<double>, std::vector<glm::vec3>>& values = built[id];
+    if (basis_size > 0)
+    {
+        SplineMotion motion = { values.first, values.second };
+        basis.evaluate(motion, yaw_sequence, offset_sequence);
+    }
+    else
+    {
+        yaw_sequence = values.first;
+        offset_sequence = values.second;
+    }
+    return true;
+}
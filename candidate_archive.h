@@ -0,0 +1,89 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <unordered_map>
+
+#include "libs/glm/glm.hpp"
+
+#include "serialize.h"
+#include "mutation.h"
+#include "spline_basis.h"
+
+struct Individual;
+
+// One evaluated candidate as the archive stores it
+struct ArchiveRecord
+{
+    uint64_t id;
+    // 0 for candidates without a parent, they carry their whole motion instead
+    uint64_t parent_id;
+    // Second parent of a recombined candidate, 0 if there is none
+    uint64_t partner_id;
+    int32_t generation;
+    int32_t score;
+    // Rungs below full fidelity the score was measured at, 0 is full fidelity
+    int32_t fidelity;
+    float seconds;
+    GaussianBump yaw_bump;
+    GaussianBump x_bump;
+    GaussianBump y_bump;
+    double crossover;
+    double blend_width;
+    // Control points when a spline basis is used, samples otherwise
+    std::vector<double> yaw_values;
+    std::vector<glm::vec3> offset_values;
+};
+
+// Append-only log of every evaluated candidate. Instead of its motion a child
+// is stored as the ids of its parents plus the recombination window and the
+// three bumps that made it, and any motion is rebuilt on demand by replaying
+// its lineage from the nearest ancestor without a parent. Records are
+// buffered into chunks of chunk_size and written column by column, ids,
+// generations and scores as varint deltas and the mutation parameters as
+// floats, each chunk with its own CRC so a torn tail is cut off on open.
+class CandidateArchive
+{
+    private:
+    int time_resolution;
+    int basis_size;
+    size_t chunk_size;
+    FILE* file;
+    // Largest id in the file or recorded since, new runs hand out ids after it
+    uint64_t largest_id;
+
+    std::vector<ArchiveRecord> pending;
+
+    // Filled by load
+    std::vector<ArchiveRecord> records;
+    std::unordered_map<uint64_t, size_t> record_index;
+    SplineBasis basis;
+
+    bool writeHeader();
+    bool readHeader(FILE* input);
+    // Reads chunks until the end or the first damaged one, returns the offset after the last good chunk
+    long readChunks(FILE* input, std::vector<ArchiveRecord>* decoded);
+    void encodeChunk(ByteWriter& writer);
+    bool decodeChunk(ByteReader& reader, uint32_t record_amount, std::vector<ArchiveRecord>& decoded);
+
+    protected:
+    public:
+    CandidateArchive(int time_resolution, int basis_size, size_t chunk_size = 4096);
+    ~CandidateArchive();
+    // Continues an existing archive of the same time resolution and basis size, or starts a new one
+    bool openForAppend(const std::string& filename);
+    void record(const Individual& individual, int generation, int fidelity, double seconds);
+    // Writes the buffered records as one chunk
+    bool flush();
+    void close();
+    // First id that no record of this archive uses yet
+    uint64_t getNextId();
+
+    // Reads a whole archive for analysis
+    bool load(const std::string& filename);
+    const std::vector<ArchiveRecord>& getRecords();
+    bool reconstruct(uint64_t id, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence);
+};
@@ -0,0 +1,280 @@
+#include "checkpoint.h"
+
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char snapshot_magic[8] = { 'S', 'O', 'F', 'A', 'C', 'K', 'P', 'T' };
+static const uint32_t snapshot_version = 2;
+static const uint32_t record_magic = 0x4c4e524a;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    int32_t generation;
+    uint64_t length;
+    uint32_t crc;
+    uint32_t reserved;
+};
+
+struct RecordHeader
+{
+    uint32_t magic;
+    int32_t generation;
+    uint32_t length;
+    uint32_t crc;
+};
+
+// Writes everything, retrying on short writes and interrupts
+static bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+static std::vector<char> readWholeFile(const std::string& filename)
+{
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile.is_open())
+    {
+        return std::vector<char>();
+    }
+    return std::vector<char>(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+}
+
+Checkpointer::Checkpointer(const std::string& snapshot_filename, const std::string& journal_filename)
+: snapshot_filename(snapshot_filename), journal_filename(journal_filename), journal_fd(-1), busy(false), stopping(false)
+{
+    // Not truncated here, a resumed run still has to read it
+    journal_fd = open(journal_filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (journal_fd < 0)
+    {
+        std::cerr << "Unable to open checkpoint journal: " << journal_filename << std::endl;
+    }
+
+    writer = std::thread(&Checkpointer::writerLoop, this);
+}
+
+Checkpointer::~Checkpointer()
+{
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    writer.join();
+
+    if (journal_fd >= 0)
+    {
+        close(journal_fd);
+    }
+}
+
+void Checkpointer::submitSnapshot(int generation, std::vector<char> bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({ true, generation, std::move(bytes) });
+    }
+    condition.notify_one();
+}
+
+void Checkpointer::submitRecord(int generation, std::vector<char> bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({ false, generation, std::move(bytes) });
+    }
+    condition.notify_one();
+}
+
+void Checkpointer::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_condition.wait(lock, [this]() { return jobs.empty() && !busy; });
+}
+
+void Checkpointer::writerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty())
+            {
+                return;
+            }
+
+            // A newer snapshot makes everything queued before it obsolete
+            for (size_t i = jobs.size(); i-- > 1;)
+            {
+                if (jobs[i].snapshot)
+                {
+                    jobs.erase(jobs.begin(), jobs.begin() + i);
+                    break;
+                }
+            }
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            busy = true;
+        }
+
+        if (job.snapshot)
+        {
+            writeSnapshot(job);
+        }
+        else
+        {
+            appendRecord(job);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy = false;
+        }
+        idle_condition.notify_all();
+    }
+}
+
+bool Checkpointer::writeSnapshot(const Job& job)
+{
+    SnapshotHeader header;
+    memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.generation = job.generation;
+    header.length = job.bytes.size();
+    header.crc = computeCrc32(job.bytes.data(), job.bytes.size());
+    header.reserved = 0;
+
+    std::string temporary_filename = snapshot_filename + ".tmp";
+    int fd = open(temporary_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Unable to open checkpoint for writing: " << temporary_filename << std::endl;
+        return false;
+    }
+
+    bool written = writeAll(fd, reinterpret_cast<const char*>(&header), sizeof(header))
+        && writeAll(fd, job.bytes.data(), job.bytes.size())
+        && fsync(fd) == 0;
+    close(fd);
+    if (!written || rename(temporary_filename.c_str(), snapshot_filename.c_str()) != 0)
+    {
+        std::cerr << "Unable to write checkpoint: " << snapshot_filename << std::endl;
+        return false;
+    }
+
+    // The rename itself only survives a crash once the directory is synced
+    size_t slash = snapshot_filename.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : snapshot_filename.substr(0, slash + 1);
+    int directory_fd = open(directory.c_str(), O_RDONLY);
+    if (directory_fd >= 0)
+    {
+        fsync(directory_fd);
+        close(directory_fd);
+    }
+
+    // Records up to this snapshot are no longer needed
+    if (journal_fd >= 0 && (ftruncate(journal_fd, 0) != 0 || fsync(journal_fd) != 0))
+    {
+        std::cerr << "Unable to reset checkpoint journal: " << journal_filename << std::endl;
+    }
+    return true;
+}
+
+bool Checkpointer::appendRecord(const Job& job)
+{
+    if (journal_fd < 0)
+    {
+        return false;
+    }
+
+    RecordHeader header;
+    header.magic = record_magic;
+    header.generation = job.generation;
+    header.length = job.bytes.size();
+    header.crc = computeCrc32(job.bytes.data(), job.bytes.size());
+
+    // One write per record keeps a torn record at the very end of the journal
+    const char* header_bytes = reinterpret_cast<const char*>(&header);
+    std::vector<char> record(header_bytes, header_bytes + sizeof(header));
+    record.insert(record.end(), job.bytes.begin(), job.bytes.end());
+
+    if (!writeAll(journal_fd, record.data(), record.size()) || fdatasync(journal_fd) != 0)
+    {
+        std::cerr << "Unable to append to checkpoint journal: " << journal_filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Checkpointer::load(int& snapshot_generation, std::vector<char>& snapshot, std::vector<std::vector<char>>& records)
+{
+    flush();
+
+    std::vector<char> snapshot_file = readWholeFile(snapshot_filename);
+    SnapshotHeader header;
+    if (snapshot_file.size() < sizeof(header))
+    {
+        std::cerr << "No checkpoint to resume from: " << snapshot_filename << std::endl;
+        return false;
+    }
+    memcpy(&header, snapshot_file.data(), sizeof(header));
+    if (memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0 || header.version != snapshot_version
+        || header.length != snapshot_file.size() - sizeof(header)
+        || header.crc != computeCrc32(snapshot_file.data() + sizeof(header), header.length))
+    {
+        std::cerr << "Checkpoint is damaged: " << snapshot_filename << std::endl;
+        return false;
+    }
+    snapshot_generation = header.generation;
+    snapshot.assign(snapshot_file.begin() + sizeof(header), snapshot_file.end());
+
+    // Replay stops at the first damaged or out of order record
+    records.clear();
+    std::vector<char> journal = readWholeFile(journal_filename);
+    size_t position = 0;
+    int last_generation = snapshot_generation;
+    while (journal.size() - position >= sizeof(RecordHeader))
+    {
+        RecordHeader record_header;
+        memcpy(&record_header, journal.data() + position, sizeof(record_header));
+        position += sizeof(record_header);
+        if (record_header.magic != record_magic || record_header.length > journal.size() - position
+            || record_header.crc != computeCrc32(journal.data() + position, record_header.length))
+        {
+            std::cerr << "Checkpoint journal ends in a damaged record, replaying the records before it" << std::endl;
+            break;
+        }
+
+        if (record_header.generation > last_generation)
+        {
+            records.push_back(std::vector<char>(journal.begin() + position, journal.begin() + position + record_header.length));
+            last_generation = record_header.generation;
+        }
+        position += record_header.length;
+    }
+
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "serialize.h"
+
+// Crash-safe persistence of a run. Snapshots hold the complete state and are
+// written to a temporary file, synced and renamed over the previous snapshot,
+// so there is always one intact snapshot on disk. Between snapshots every
+// generation appends a small record to a journal. Records carry their
+// generation, so records older than the snapshot are skipped on load, and a
+// record torn by a crash fails its checksum and ends the replay.
+// All file work happens on a background thread, submitting only copies bytes.
+class Checkpointer
+{
+    private:
+    struct Job
+    {
+        bool snapshot;
+        int32_t generation;
+        std::vector<char> bytes;
+    };
+
+    std::string snapshot_filename;
+    std::string journal_filename;
+    int journal_fd;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable idle_condition;
+    std::deque<Job> jobs;
+    bool busy;
+    bool stopping;
+
+    void writerLoop();
+    bool writeSnapshot(const Job& job);
+    bool appendRecord(const Job& job);
+
+    protected:
+    public:
+    Checkpointer(const std::string& snapshot_filename, const std::string& journal_filename);
+    ~Checkpointer();
+    // Replaces the snapshot and empties the journal
+    void submitSnapshot(int generation, std::vector<char> bytes);
+    void submitRecord(int generation, std::vector<char> bytes);
+    // Blocks until every submitted job is on disk
+    void flush();
+    // Returns false if there is no intact snapshot, records are the valid journal entries after it in order
+    bool load(int& snapshot_generation, std::vector<char>& snapshot, std::vector<std::vector<char>>& records);
+};
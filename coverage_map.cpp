@@ -0,0 +1,216 @@
+#include "coverage_map.h"
+
+void subtractRanges(const std::vector<PixelRange>& a, const std::vector<PixelRange>& b, std::vector<PixelRange>& result)
+{
+    result.clear();
+    size_t j = 0;
+    for (const PixelRange& range : a)
+    {
+        int first = range.first;
+        while (j < b.size() && b[j].last < first)
+        {
+            j++;
+        }
+        for (size_t k = j; k < b.size() && b[k].first <= range.last; k++)
+        {
+            if (b[k].first > first)
+            {
+                result.push_back({ first, b[k].first - 1 });
+            }
+            first = std::max(first, b[k].last + 1);
+        }
+        if (first <= range.last)
+        {
+            result.push_back({ first, range.last });
+        }
+    }
+}
+
+CoverageMap::CoverageMap(int frame_width, int frame_height, glm::vec3 anchor)
+: frame_width(frame_width), frame_height(frame_height), anchor(anchor), remaining_pixel(0)
+{
+
+}
+
+void CoverageMap::poseRowRanges(double cos_yaw, double sin_yaw, glm::vec3 offset, int row, std::vector<PixelRange>& ranges)
+{
+    ranges.clear();
+    double y = (row + 0.5) * 2.0 / frame_height - 1.0;
+    for (int w = 0; w < hallway_wall_amount; w++)
+    {
+        RowInterval covered;
+        if (!wallRowInterval(hallway_walls[w], y, cos_yaw, sin_yaw, offset, anchor, covered))
+        {
+            continue;
+        }
+
+        // Pixel k has its center at (k + 0.5) * 2 / width - 1
+        int first = (int)std::max(std::floor((covered.begin + 1.0) * frame_width / 2.0 - 0.5) + 1.0, 0.0);
+        int last = (int)std::min(std::ceil((covered.end + 1.0) * frame_width / 2.0 - 0.5) - 1.0, (double)frame_width - 1);
+        if (first <= last)
+        {
+            ranges.push_back({ first, last });
+        }
+    }
+
+    // The walls are disjoint, so sorting is all it takes
+    std::sort(ranges.begin(), ranges.end(), [](const PixelRange& a, const PixelRange& b)
+    {
+        return a.first < b.first;
+    });
+}
+
+void CoverageMap::build(const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence)
+{
+    this->yaw_sequence = yaw_sequence;
+    this->offset_sequence = offset_sequence;
+
+    int time_resolution = (int)yaw_sequence.size();
+    std::vector<double> cos_yaw(time_resolution);
+    std::vector<double> sin_yaw(time_resolution);
+    for (int i = 0; i < time_resolution; i++)
+    {
+        cos_yaw[i] = cos(yaw_sequence[i]);
+        sin_yaw[i] = sin(yaw_sequence[i]);
+    }
+
+    counts.assign((size_t)frame_width * frame_height, 0);
+    frame_sums.assign((size_t)frame_width * frame_height, 0);
+    remaining_pixel = 0;
+
+    // Difference arrays turn every range into two updates per row
+    std::vector<int32_t> count_steps(frame_width + 1);
+    std::vector<int64_t> sum_steps(frame_width + 1);
+    std::vector<PixelRange> ranges;
+    for (int row = 0; row < frame_height; row++)
+    {
+        std::fill(count_steps.begin(), count_steps.end(), 0);
+        std::fill(sum_steps.begin(), sum_steps.end(), 0);
+        for (int i = 0; i < time_resolution; i++)
+        {
+            poseRowRanges(cos_yaw[i], sin_yaw[i], offset_sequence[i], row, ranges);
+            for (const PixelRange& range : ranges)
+            {
+                count_steps[range.first]++;
+                count_steps[range.last + 1]--;
+                sum_steps[range.first] += i;
+                sum_steps[range.last + 1] -= i;
+            }
+        }
+
+        int32_t count = 0;
+        int64_t sum = 0;
+        size_t row_start = (size_t)row * frame_width;
+        for (int x = 0; x < frame_width; x++)
+        {
+            count += count_steps[x];
+            sum += sum_steps[x];
+            counts[row_start + x] = (uint16_t)count;
+            frame_sums[row_start + x] = (uint32_t)sum;
+            if (count == 0)
+            {
+                remaining_pixel++;
+            }
+        }
+    }
+}
+
+int CoverageMap::getRemainingPixel()
+{
+    return remaining_pixel;
+}
+
+const std::vector<double>& CoverageMap::getYawSequence()
+{
+    return yaw_sequence;
+}
+
+const std::vector<glm::vec3>& CoverageMap::getOffsetSequence()
+{
+    return offset_sequence;
+}
+
+int CoverageMap::updateFrame(int frame, double yaw, glm::vec3 offset, bool apply)
+{
+    double old_cos = cos(yaw_sequence[frame]);
+    double old_sin = sin(yaw_sequence[frame]);
+    double new_cos = cos(yaw);
+    double new_sin = sin(yaw);
+
+    int remaining = remaining_pixel;
+    for (int row = 0; row < frame_height; row++)
+    {
+        poseRowRanges(old_cos, old_sin, offset_sequence[frame], row, old_ranges);
+        poseRowRanges(new_cos, new_sin, offset, row, new_ranges);
+        size_t row_start = (size_t)row * frame_width;
+
+        // Uncovered by the move, pixels only this frame covered come back
+        subtractRanges(old_ranges, new_ranges, difference);
+        for (const PixelRange& range : difference)
+        {
+            for (int x = range.first; x <= range.last; x++)
+            {
+                size_t pixel = row_start + x;
+                if (counts[pixel] == 1)
+                {
+                    remaining++;
+                }
+                if (apply)
+                {
+                    counts[pixel]--;
+                    frame_sums[pixel] -= frame;
+                }
+            }
+        }
+
+        // Newly covered, pixels nobody covered are lost
+        subtractRanges(new_ranges, old_ranges, difference);
+        for (const PixelRange& range : difference)
+        {
+            for (int x = range.first; x <= range.last; x++)
+            {
+                size_t pixel = row_start + x;
+                if (counts[pixel] == 0)
+                {
+                    remaining--;
+                }
+                if (apply)
+                {
+                    counts[pixel]++;
+                    frame_sums[pixel] += frame;
+                }
+            }
+        }
+    }
+
+    if (apply)
+    {
+        yaw_sequence[frame] = yaw;
+        offset_sequence[frame] = offset;
+        remaining_pixel = remaining;
+    }
+    return remaining;
+}
+
+int CoverageMap::probeFrame(int frame, double yaw, glm::vec3 offset)
+{
+    return updateFrame(frame, yaw, offset, false);
+}
+
+void CoverageMap::moveFrame(int frame, double yaw, glm::vec3 offset)
+{
+    updateFrame(frame, yaw, offset, true);
+}
+
+std::vector<int> CoverageMap::uniqueKills()
+{
+    std::vector<int> kills(yaw_sequence.size(), 0);
+    for (size_t pixel = 0; pixel < counts.size(); pixel++)
+    {
+        if (counts[pixel] == 1 && frame_sums[pixel] < kills.size())
+        {
+            kills[frame_sums[pixel]]++;
+        }
+    }
+    return kills;
+}
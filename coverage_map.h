@@ -0,0 +1,65 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "libs/glm/glm.hpp"
+
+#include "hallway.h"
+#include "cpu_rasterizer.h"
+
+// Inclusive range of pixel columns on one row
+struct PixelRange
+{
+    int first;
+    int last;
+};
+
+// For every pixel the number of frames whose walls cover it and the sum of
+// their frame indices. A pixel with count 0 remains, a pixel with count 1 is
+// killed by exactly one frame, whose index is then the sum. Moving one frame
+// only touches the pixels between its old and new wall edges, so a probe
+// costs a few row operations instead of a full render.
+class CoverageMap
+{
+    private:
+    int frame_width;
+    int frame_height;
+    glm::vec3 anchor;
+
+    std::vector<uint16_t> counts;
+    std::vector<uint32_t> frame_sums;
+    int remaining_pixel;
+
+    std::vector<double> yaw_sequence;
+    std::vector<glm::vec3> offset_sequence;
+
+    // Scratch of updateFrame
+    std::vector<PixelRange> old_ranges;
+    std::vector<PixelRange> new_ranges;
+    std::vector<PixelRange> difference;
+
+    // Columns whose pixel centers lie strictly inside the walls of one pose on a row, sorted
+    void poseRowRanges(double cos_yaw, double sin_yaw, glm::vec3 offset, int row, std::vector<PixelRange>& ranges);
+    // Score after moving the frame, the map only changes if apply is set
+    int updateFrame(int frame, double yaw, glm::vec3 offset, bool apply);
+
+    protected:
+    public:
+    CoverageMap(int frame_width, int frame_height, glm::vec3 anchor);
+    void build(const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence);
+    int getRemainingPixel();
+    const std::vector<double>& getYawSequence();
+    const std::vector<glm::vec3>& getOffsetSequence();
+    // Remaining pixels if the frame had this pose, the map is left unchanged
+    int probeFrame(int frame, double yaw, glm::vec3 offset);
+    void moveFrame(int frame, double yaw, glm::vec3 offset);
+    // Pixels each frame kills on its own, the frames with any bind the sofa boundary
+    std::vector<int> uniqueKills();
+};
+
+// Parts of the sorted disjoint ranges a that are not in the sorted disjoint ranges b
+void subtractRanges(const std::vector<PixelRange>& a, const std::vector<PixelRange>& b, std::vector<PixelRange>& result);
@@ -0,0 +1,140 @@
+#include "cpu_rasterizer.h"
+
+#include "perf_counters.h"
+
+// Solves min <= slope * x + intercept <= max for x, returns false if no x does
+static inline bool solveSlab(double slope, double intercept, double min, double max, double& lower, double& upper)
+{
+    if (std::fabs(slope) < 1e-12)
+    {
+        if (intercept < min || intercept > max)
+        {
+            return false;
+        }
+        lower = -HUGE_VAL;
+        upper = HUGE_VAL;
+        return true;
+    }
+
+    double a = (min - intercept) / slope;
+    double b = (max - intercept) / slope;
+    lower = std::min(a, b);
+    upper = std::max(a, b);
+    return true;
+}
+
+bool wallRowInterval(const WallRect& wall, double y, double cos_yaw, double sin_yaw, glm::vec3 offset, glm::vec3 anchor, RowInterval& covered)
+{
+    // Local wall coordinates of the point (x, y) are linear in x
+    double shift_x = offset.x + anchor.x;
+    double dy = y - offset.y - anchor.y;
+    double intercept_x = -cos_yaw * shift_x + sin_yaw * dy + anchor.x;
+    double intercept_y = sin_yaw * shift_x + cos_yaw * dy + anchor.y;
+
+    double lower_x, upper_x, lower_y, upper_y;
+    if (!solveSlab(cos_yaw, intercept_x, wall.min_x, wall.max_x, lower_x, upper_x))
+    {
+        return false;
+    }
+    if (!solveSlab(-sin_yaw, intercept_y, wall.min_y, wall.max_y, lower_y, upper_y))
+    {
+        return false;
+    }
+
+    covered.begin = std::max(lower_x, lower_y);
+    covered.end = std::min(upper_x, upper_y);
+    return covered.begin < covered.end;
+}
+
+void subtractInterval(std::vector<RowInterval>& intervals, const RowInterval& covered, std::vector<RowInterval>& scratch)
+{
+    scratch.clear();
+    for (const RowInterval& interval : intervals)
+    {
+        if (covered.end <= interval.begin || covered.begin >= interval.end)
+        {
+            scratch.push_back(interval);
+            continue;
+        }
+        if (covered.begin > interval.begin)
+        {
+            scratch.push_back({ interval.begin, covered.begin });
+        }
+        if (covered.end < interval.end)
+        {
+            scratch.push_back({ covered.end, interval.end });
+        }
+    }
+    intervals.swap(scratch);
+}
+
+int countPixelCenters(const RowInterval& interval, int frame_width)
+{
+    // Pixel k has its center at (k + 0.5) * 2 / width - 1
+    double first = std::ceil((interval.begin + 1.0) * frame_width / 2.0 - 0.5);
+    double last = std::floor((interval.end + 1.0) * frame_width / 2.0 - 0.5);
+    first = std::max(first, 0.0);
+    last = std::min(last, (double)frame_width - 1);
+    return last >= first ? (int)(last - first) + 1 : 0;
+}
+
+CpuRasterizer::CpuRasterizer(int frame_width, int frame_height)
+: FRAME_WIDTH(frame_width), FRAME_HEIGHT(frame_height)
+{
+
+}
+
+int CpuRasterizer::getFrameWidth()
+{
+    return FRAME_WIDTH;
+}
+
+int CpuRasterizer::getFrameHeight()
+{
+    return FRAME_HEIGHT;
+}
+
+int CpuRasterizer::Render(int time_resolution, glm::vec3 anchor, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence)
+{
+    // Counting is interleaved with the rows, the whole evaluation is render
+    PerfScope perf_scope(PERF_PHASE_RENDER);
+
+    std::vector<double> cos_yaw(time_resolution);
+    std::vector<double> sin_yaw(time_resolution);
+    for (int i = 0; i < time_resolution; i++)
+    {
+        cos_yaw[i] = cos(yaw_sequence[i]);
+        sin_yaw[i] = sin(yaw_sequence[i]);
+    }
+
+    std::vector<RowInterval> alive;
+    std::vector<RowInterval> scratch;
+    int remaining_pixel = 0;
+
+    for (int row = 0; row < FRAME_HEIGHT; row++)
+    {
+        double y = (row + 0.5) * 2.0 / FRAME_HEIGHT - 1.0;
+
+        alive.clear();
+        alive.push_back({ -1.0, 1.0 });
+
+        for (int i = 0; i < time_resolution && !alive.empty(); i++)
+        {
+            for (int w = 0; w < hallway_wall_amount; w++)
+            {
+                RowInterval covered;
+                if (wallRowInterval(hallway_walls[w], y, cos_yaw[i], sin_yaw[i], offset_sequence[i], anchor, covered))
+                {
+                    subtractInterval(alive, covered, scratch);
+                }
+            }
+        }
+
+        for (const RowInterval& interval : alive)
+        {
+            remaining_pixel += countPixelCenters(interval, FRAME_WIDTH);
+        }
+    }
+
+    return remaining_pixel;
+}
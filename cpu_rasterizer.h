@@ -0,0 +1,42 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "libs/glm/glm.hpp"
+
+#include "hallway.h"
+
+// Open interval of x coordinates on one pixel row
+struct RowInterval
+{
+    double begin;
+    double end;
+};
+
+// Exact CPU counterpart of Renderer::Render that needs no GL context, so one
+// instance per thread can evaluate in parallel. Every pixel row keeps the x
+// intervals that no transformed wall has covered so far. Each frame subtracts
+// the covered interval of every wall, and the pixel centers left in the
+// intervals after the last frame are the remaining pixels.
+class CpuRasterizer
+{
+    private:
+    const int FRAME_WIDTH;
+    const int FRAME_HEIGHT;
+
+    protected:
+    public:
+    CpuRasterizer(int frame_width, int frame_height);
+    int getFrameWidth();
+    int getFrameHeight();
+    int Render(int time_resolution, glm::vec3 anchor, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence);
+};
+
+// Interval of the row at height y covered by a wall rotated by yaw about anchor and moved by offset
+bool wallRowInterval(const WallRect& wall, double y, double cos_yaw, double sin_yaw, glm::vec3 offset, glm::vec3 anchor, RowInterval& covered);
+// Removes covered from the sorted disjoint intervals
+void subtractInterval(std::vector<RowInterval>& intervals, const RowInterval& covered, std::vector<RowInterval>& scratch);
+// Number of pixel centers of a row that lie inside the interval
+int countPixelCenters(const RowInterval& interval, int frame_width);
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Writes shader_sources.h with every shaders/*.glsl as a string constant named after the file
+output=shader_sources.h
+{
+    echo "#pragma once"
+    echo
+    echo "// Generated by embed_shaders.sh from shaders/*.glsl, do not edit"
+    for shader in shaders/*.glsl; do
+        name=$(basename "$shader" .glsl)
+        echo
+        printf 'static const char %s_source[] = R"glsl(' "$name"
+        cat "$shader"
+        echo ')glsl";'
+    done
+} > "$output.tmp" && mv "$output.tmp" "$output"
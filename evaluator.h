@@ -0,0 +1,18 @@
+#pragma once
+
+// Backend that produced a score, scores of different backends are not interchangeable
+enum EvaluatorBackend
+{
+    BACKEND_GL = 0,
+    BACKEND_SOFT = 1,
+    BACKEND_CPU = 2
+};
+
+// Everything besides the motion itself that determines a score
+struct EvaluatorConfig
+{
+    int frame_width;
+    int frame_height;
+    int time_resolution;
+    int backend;
+};
@@ -0,0 +1,140 @@
+#include "evaluator_pool.h"
+
+EvaluatorPool::EvaluatorPool(int worker_amount, int frame_width, int frame_height, int time_resolution, glm::vec3 anchor)
+: worker_amount(std::max(worker_amount, 1)), frame_width(frame_width), frame_height(frame_height), time_resolution(time_resolution), anchor(anchor),
+  tasks(4 * std::max(worker_amount, 1)), results(4 * std::max(worker_amount, 1)), stopping(false), telemetry(nullptr)
+{
+
+}
+
+EvaluatorPool::~EvaluatorPool()
+{
+    stop();
+}
+
+void EvaluatorPool::start()
+{
+    if (!workers.empty())
+    {
+        return;
+    }
+
+    stopping.store(false);
+    for (int w = 0; w < worker_amount; w++)
+    {
+        workers.push_back(std::thread(&EvaluatorPool::workerLoop, this));
+    }
+}
+
+void EvaluatorPool::stop()
+{
+    stopping.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        task_added.notify_all();
+        result_taken.notify_all();
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void EvaluatorPool::notify(std::condition_variable& condition)
+{
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    condition.notify_one();
+}
+
+void EvaluatorPool::workerLoop()
+{
+    CpuRasterizer rasterizer(frame_width, frame_height);
+
+    EvaluationTask task;
+    while (true)
+    {
+        bool popped = tasks.pop(task);
+        if (!popped)
+        {
+            std::unique_lock<std::mutex> lock(wait_mutex);
+            task_added.wait(lock, [&]()
+            {
+                popped = tasks.pop(task);
+                return popped || stopping.load(std::memory_order_acquire);
+            });
+        }
+        // Stopping only ends the loop once the queued tasks are done
+        if (!popped)
+        {
+            break;
+        }
+        notify(task_taken);
+
+        auto start = std::chrono::steady_clock::now();
+        EvaluationResult result;
+        result.id = task.id;
+        result.score = rasterizer.Render(time_resolution, anchor, task.yaw_sequence, task.offset_sequence);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (telemetry)
+        {
+            telemetry->log(-1, task.id, result.score, result.seconds);
+        }
+
+        if (!results.push(result))
+        {
+            std::unique_lock<std::mutex> lock(wait_mutex);
+            result_taken.wait(lock, [&]()
+            {
+                return results.push(result) || stopping.load(std::memory_order_acquire);
+            });
+        }
+        notify(result_added);
+    }
+}
+
+void EvaluatorPool::submit(const EvaluationTask& task)
+{
+    if (!tasks.push(task))
+    {
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        task_taken.wait(lock, [&]()
+        {
+            return tasks.push(task);
+        });
+    }
+    notify(task_added);
+}
+
+bool EvaluatorPool::poll(EvaluationResult& result)
+{
+    if (!results.pop(result))
+    {
+        return false;
+    }
+    notify(result_taken);
+    return true;
+}
+
+void EvaluatorPool::waitForResult(EvaluationResult& result)
+{
+    if (!results.pop(result))
+    {
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        result_added.wait(lock, [&]()
+        {
+            return results.pop(result);
+        });
+    }
+    notify(result_taken);
+}
+
+int EvaluatorPool::getWorkerAmount()
+{
+    return worker_amount;
+}
+
+void EvaluatorPool::setTelemetry(TelemetryLogger* telemetry)
+{
+    this->telemetry = telemetry;
+}
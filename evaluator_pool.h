@@ -0,0 +1,77 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "libs/glm/glm.hpp"
+
+#include "cpu_rasterizer.h"
+#include "lockfree_queue.h"
+#include "telemetry.h"
+
+struct EvaluationTask
+{
+    int id;
+    std::vector<double> yaw_sequence;
+    std::vector<glm::vec3> offset_sequence;
+};
+
+struct EvaluationResult
+{
+    int id;
+    int score;
+    // Evaluator time spent on the task
+    double seconds;
+};
+
+// Worker threads with their own CpuRasterizer that take tasks from a lock-free
+// queue as soon as they are free and push scores to a lock-free result queue.
+// Only one thread submits and polls, the workers never touch optimizer state.
+// The queues carry the data, a thread that finds its queue empty or full
+// sleeps on a condition variable until the other side signals.
+class EvaluatorPool
+{
+    private:
+    int worker_amount;
+    int frame_width;
+    int frame_height;
+    int time_resolution;
+    glm::vec3 anchor;
+
+    LockFreeQueue<EvaluationTask> tasks;
+    LockFreeQueue<EvaluationResult> results;
+    std::atomic<bool> stopping;
+
+    std::mutex wait_mutex;
+    std::condition_variable task_added;
+    std::condition_variable task_taken;
+    std::condition_variable result_added;
+    std::condition_variable result_taken;
+    std::vector<std::thread> workers;
+    TelemetryLogger* telemetry;
+
+    void workerLoop();
+    // Taking the mutex orders the notification after a waiter's last look at the queue
+    void notify(std::condition_variable& condition);
+
+    protected:
+    public:
+    EvaluatorPool(int worker_amount, int frame_width, int frame_height, int time_resolution, glm::vec3 anchor);
+    ~EvaluatorPool();
+    void start();
+    // Joins the workers once the queued tasks are done
+    void stop();
+    // Waits for room in the task queue
+    void submit(const EvaluationTask& task);
+    bool poll(EvaluationResult& result);
+    // Sleeps until a result arrives, only call it with tasks in flight
+    void waitForResult(EvaluationResult& result);
+    int getWorkerAmount();
+    // Workers log every evaluation with generation -1 and the task id as individual
+    void setTelemetry(TelemetryLogger* telemetry);
+};
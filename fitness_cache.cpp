@@ -0,0 +1,346 @@
+#include "fitness_cache.h"
+
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char cache_magic[8] = { 'S', 'O', 'F', 'A', 'C', 'A', 'C', 'H' };
+static const uint32_t cache_version = 1;
+// Tables are not filled beyond this load so probes stay short
+static const double cache_max_load = 0.7;
+
+struct CacheFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t capacity;
+    uint64_t count;
+};
+
+// An all zero key marks an empty slot
+struct CacheFileEntry
+{
+    uint64_t low;
+    uint64_t high;
+    int64_t score;
+};
+
+// Holds a flock on the cache file for one scope, concurrent runs in a directory share the file
+struct CacheFileLock
+{
+    int file_descriptor;
+
+    CacheFileLock(int file_descriptor, int operation)
+    : file_descriptor(file_descriptor)
+    {
+        while (flock(file_descriptor, operation) != 0 && errno == EINTR)
+        {
+        }
+    }
+
+    ~CacheFileLock()
+    {
+        flock(file_descriptor, LOCK_UN);
+    }
+};
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// MurmurHash3 x64 128 over whole 64 bit words
+static Hash128 murmurHash128(const std::vector<uint64_t>& words, uint64_t seed)
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+    size_t pair_amount = words.size() / 2;
+
+    for (size_t i = 0; i < pair_amount; i++)
+    {
+        uint64_t k1 = words[2 * i];
+        uint64_t k2 = words[2 * i + 1];
+
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    if (words.size() % 2 == 1)
+    {
+        uint64_t k1 = words.back();
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    uint64_t length = words.size() * sizeof(uint64_t);
+    h1 ^= length;
+    h2 ^= length;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    Hash128 hash;
+    hash.low = h1;
+    hash.high = h2;
+    return hash;
+}
+
+FitnessCache::FitnessCache(EvaluatorConfig config)
+: config(config), file_descriptor(-1), mapping(nullptr), mapping_size(0), capacity(0), hits(0), misses(0)
+{
+
+}
+
+FitnessCache::~FitnessCache()
+{
+    closeFile();
+}
+
+bool FitnessCache::openFile(const std::string& filename, uint64_t capacity)
+{
+    closeFile();
+
+    file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file_descriptor < 0)
+    {
+        std::cerr << "Unable to open fitness cache file: " << filename << std::endl;
+        return false;
+    }
+
+    // Another run may be creating the file right now, it is checked and sized by one run at a time
+    bool mapped;
+    {
+        CacheFileLock lock(file_descriptor, LOCK_EX);
+        mapped = mapFile(filename, capacity);
+    }
+    if (!mapped)
+    {
+        closeFile();
+        return false;
+    }
+
+    std::cout << "Fitness cache " << filename << " holds " << ((CacheFileHeader*)mapping)->count << " entries." << std::endl;
+    return true;
+}
+
+bool FitnessCache::mapFile(const std::string& filename, uint64_t capacity)
+{
+    struct stat file_stat;
+    if (fstat(file_descriptor, &file_stat) != 0)
+    {
+        std::cerr << "Unable to inspect fitness cache file: " << filename << std::endl;
+        return false;
+    }
+
+    // Only an empty file is given a layout, whatever else is there is left alone
+    bool existing = file_stat.st_size > 0;
+    if (existing)
+    {
+        CacheFileHeader header;
+        bool known = file_stat.st_size >= (off_t)sizeof(CacheFileHeader)
+            && pread(file_descriptor, &header, sizeof(header), 0) == (ssize_t)sizeof(header)
+            && memcmp(header.magic, cache_magic, sizeof(cache_magic)) == 0 && header.version == cache_version
+            && (off_t)(sizeof(CacheFileHeader) + header.capacity * sizeof(CacheFileEntry)) == file_stat.st_size;
+        if (!known)
+        {
+            std::cerr << "Fitness cache file has an unknown layout, running without it until it is removed: " << filename << std::endl;
+            return false;
+        }
+        capacity = header.capacity;
+    }
+    else if (ftruncate(file_descriptor, sizeof(CacheFileHeader) + capacity * sizeof(CacheFileEntry)) != 0)
+    {
+        std::cerr << "Unable to size fitness cache file: " << filename << std::endl;
+        return false;
+    }
+
+    this->capacity = capacity;
+    mapping_size = sizeof(CacheFileHeader) + capacity * sizeof(CacheFileEntry);
+    mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Unable to map fitness cache file: " << filename << std::endl;
+        mapping = nullptr;
+        return false;
+    }
+
+    if (!existing)
+    {
+        CacheFileHeader* mapped_header = (CacheFileHeader*)mapping;
+        memcpy(mapped_header->magic, cache_magic, sizeof(cache_magic));
+        mapped_header->version = cache_version;
+        mapped_header->reserved = 0;
+        mapped_header->capacity = capacity;
+        mapped_header->count = 0;
+    }
+    return true;
+}
+
+void FitnessCache::closeFile()
+{
+    if (mapping)
+    {
+        msync(mapping, mapping_size, MS_SYNC);
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+    }
+    if (file_descriptor >= 0)
+    {
+        close(file_descriptor);
+        file_descriptor = -1;
+    }
+    capacity = 0;
+}
+
+Hash128 FitnessCache::hashCandidate(const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence)
+{
+    // The z component of the offsets is always zero and not part of the key
+    std::vector<uint64_t> words;
+    words.reserve(yaw_sequence.size() + offset_sequence.size() + 4);
+
+    for (double yaw : yaw_sequence)
+    {
+        uint64_t bits;
+        memcpy(&bits, &yaw, sizeof(bits));
+        words.push_back(bits);
+    }
+    for (const glm::vec3& offset : offset_sequence)
+    {
+        uint32_t x;
+        uint32_t y;
+        memcpy(&x, &offset.x, sizeof(x));
+        memcpy(&y, &offset.y, sizeof(y));
+        words.push_back(((uint64_t)y << 32) | x);
+    }
+
+    words.push_back((uint64_t)config.frame_width);
+    words.push_back((uint64_t)config.frame_height);
+    words.push_back((uint64_t)config.time_resolution);
+    words.push_back((uint64_t)config.backend);
+
+    Hash128 hash = murmurHash128(words, 0x50FA50FA50FA50FAULL);
+    // Never produce the empty slot marker
+    hash.high |= 1;
+    return hash;
+}
+
+bool FitnessCache::lookup(const Hash128& key, int& score)
+{
+    auto it = memory.find(key);
+    if (it != memory.end())
+    {
+        score = it->second;
+        hits++;
+        return true;
+    }
+
+    if (lookupFile(key, score))
+    {
+        memory[key] = score;
+        hits++;
+        return true;
+    }
+
+    misses++;
+    return false;
+}
+
+void FitnessCache::insert(const Hash128& key, int score)
+{
+    memory[key] = score;
+    insertFile(key, score);
+}
+
+bool FitnessCache::lookupFile(const Hash128& key, int& score)
+{
+    if (!mapping)
+    {
+        return false;
+    }
+
+    // Keeps out inserts of other runs while an entry is half written
+    CacheFileLock lock(file_descriptor, LOCK_SH);
+    CacheFileEntry* entries = (CacheFileEntry*)((char*)mapping + sizeof(CacheFileHeader));
+    for (uint64_t probe = 0; probe < capacity; probe++)
+    {
+        CacheFileEntry& entry = entries[(key.low + probe) % capacity];
+        if (entry.low == 0 && entry.high == 0)
+        {
+            return false;
+        }
+        if (entry.low == key.low && entry.high == key.high)
+        {
+            score = (int)entry.score;
+            return true;
+        }
+    }
+    return false;
+}
+
+void FitnessCache::insertFile(const Hash128& key, int score)
+{
+    if (!mapping)
+    {
+        return;
+    }
+
+    // Runs sharing the file claim slots and count entries one at a time
+    CacheFileLock lock(file_descriptor, LOCK_EX);
+    CacheFileHeader* header = (CacheFileHeader*)mapping;
+    if (header->count + 1 > cache_max_load * capacity)
+    {
+        return;
+    }
+
+    CacheFileEntry* entries = (CacheFileEntry*)((char*)mapping + sizeof(CacheFileHeader));
+    for (uint64_t probe = 0; probe < capacity; probe++)
+    {
+        CacheFileEntry& entry = entries[(key.low + probe) % capacity];
+        if (entry.low == key.low && entry.high == key.high)
+        {
+            entry.score = score;
+            return;
+        }
+        if (entry.low == 0 && entry.high == 0)
+        {
+            entry.score = score;
+            entry.low = key.low;
+            entry.high = key.high;
+            header->count++;
+            return;
+        }
+    }
+}
+
+size_t FitnessCache::getHitCount()
+{
+    return hits;
+}
+
+size_t FitnessCache::getMissCount()
+{
+    return misses;
+}
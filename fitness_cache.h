@@ -0,0 +1,66 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+#include "libs/glm/glm.hpp"
+
+#include "evaluator.h"
+
+struct Hash128
+{
+    uint64_t low;
+    uint64_t high;
+
+    bool operator==(const Hash128& other) const
+    {
+        return low == other.low && high == other.high;
+    }
+};
+
+struct Hash128Hasher
+{
+    size_t operator()(const Hash128& hash) const
+    {
+        return (size_t)(hash.low ^ (hash.high * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+// Scores keyed by a 128 bit hash of the candidate and the evaluator configuration.
+// Lookups go to an in-memory map first and then to an optional memory-mapped
+// open addressing table on disk that survives restarts.
+class FitnessCache
+{
+    private:
+    EvaluatorConfig config;
+
+    std::unordered_map<Hash128, int, Hash128Hasher> memory;
+
+    int file_descriptor;
+    void* mapping;
+    size_t mapping_size;
+    uint64_t capacity;
+
+    size_t hits;
+    size_t misses;
+
+    // Checks an existing file or lays out an empty one, called with the file locked
+    bool mapFile(const std::string& filename, uint64_t capacity);
+    bool lookupFile(const Hash128& key, int& score);
+    void insertFile(const Hash128& key, int score);
+
+    protected:
+    public:
+    FitnessCache(EvaluatorConfig config);
+    ~FitnessCache();
+    bool openFile(const std::string& filename, uint64_t capacity);
+    void closeFile();
+    Hash128 hashCandidate(const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence);
+    bool lookup(const Hash128& key, int& score);
+    void insert(const Hash128& key, int score);
+    size_t getHitCount();
+    size_t getMissCount();
+};
@@ -0,0 +1,58 @@
+#include "gl_evaluator.h"
+
+#include "hallway.h"
+#include "shader_program.h"
+
+bool createGlEvaluatorContext(const std::string& title, int frame_width, int frame_height, GlEvaluatorContext& gl)
+{
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+    {
+        std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    gl.window = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, frame_width, frame_height, SDL_WINDOW_OPENGL);
+    if (!gl.window)
+    {
+        std::cerr << "Failed to create SDL window: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    gl.context = SDL_GL_CreateContext(gl.window);
+
+    GLenum err = glewInit();
+    if (err != GLEW_OK)
+    {
+        std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(err) << std::endl;
+        SDL_GL_DeleteContext(gl.context);
+        SDL_DestroyWindow(gl.window);
+        return false;
+    }
+    gl.program = buildShaderProgram("shader_cache.bin");
+    if (!gl.program)
+    {
+        SDL_GL_DeleteContext(gl.context);
+        SDL_DestroyWindow(gl.window);
+        return false;
+    }
+
+    std::vector<float> vertices = buildHallwayVertices();
+    glGenVertexArrays(1, &gl.vertex_array);
+    glGenBuffers(1, &gl.vertex_buffer);
+    glBindVertexArray(gl.vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, gl.vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glViewport(0, 0, frame_width, frame_height);
+    glUseProgram(gl.program);
+    return true;
+}
+
+void destroyGlEvaluatorContext(GlEvaluatorContext& gl)
+{
+    glDeleteVertexArrays(1, &gl.vertex_array);
+    glDeleteBuffers(1, &gl.vertex_buffer);
+    glDeleteProgram(gl.program);
+    SDL_GL_DeleteContext(gl.context);
+    SDL_DestroyWindow(gl.window);
+}
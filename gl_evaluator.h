@@ -0,0 +1,24 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include <SDL2/SDL.h>
+#include <GL/glew.h>
+
+// Window, context and hallway geometry a Renderer needs, for tools that
+// evaluate on the GL backend outside of the main program
+struct GlEvaluatorContext
+{
+    SDL_Window* window;
+    SDL_GLContext context;
+    GLuint program;
+    GLuint vertex_array;
+    GLuint vertex_buffer;
+};
+
+// Initializes SDL if needed and opens a frame_width x frame_height window with the hallway bound
+bool createGlEvaluatorContext(const std::string& title, int frame_width, int frame_height, GlEvaluatorContext& gl);
+// Releases the window and the GL objects, SDL itself stays initialized
+void destroyGlEvaluatorContext(GlEvaluatorContext& gl);
@@ -0,0 +1,323 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <functional>
+#include <chrono>
+#include <cstdlib>
+
+#include "libs/glm/glm.hpp"
+
+#include "optimizer.h"
+#include "renderer.h"
+#include "cpu_rasterizer.h"
+#include "soft_rasterizer.h"
+#include "seed_motions.h"
+#include "motion_file.h"
+#include "gl_evaluator.h"
+
+// The fixed part of every golden run
+const int time_resolution = 1000;
+const int population_amount = 10;
+const int surviver_amount = 3;
+const int basis_size = 32;
+const uint64_t seed = 1;
+// The soft score sums per-thread areas in thread order, a fixed thread count keeps it reproducible
+const int soft_threads = 4;
+const glm::vec3 anchor = glm::vec3(0.0f, 0.0f, 0.0f);
+
+// One line of the golden file, with what the last run measured
+struct GoldenRun
+{
+    std::string backend;
+    int frame_width;
+    int frame_height;
+    int generations;
+    // Best score after the last generation and how many pixels it may differ by
+    int score;
+    int score_tolerance;
+    // Whole run throughput and the fraction it may fall below it
+    double evaluations_per_second;
+    double throughput_tolerance;
+    long peak_rss_kb;
+
+    bool measured;
+    int measured_score;
+    double measured_evaluations_per_second;
+    long measured_peak_rss_kb;
+};
+
+static bool setGoldenField(GoldenRun& run, const std::string& key, const std::string& value)
+{
+    if (key == "backend") run.backend = value;
+    else if (key == "frame_width") run.frame_width = atoi(value.c_str());
+    else if (key == "frame_height") run.frame_height = atoi(value.c_str());
+    else if (key == "generations") run.generations = atoi(value.c_str());
+    else if (key == "score") run.score = atoi(value.c_str());
+    else if (key == "score_tolerance") run.score_tolerance = atoi(value.c_str());
+    else if (key == "evaluations_per_second") run.evaluations_per_second = atof(value.c_str());
+    else if (key == "throughput_tolerance") run.throughput_tolerance = atof(value.c_str());
+    else if (key == "peak_rss_kb") run.peak_rss_kb = atol(value.c_str());
+    else return false;
+    return true;
+}
+
+// Lines of key=value terms, empty lines and lines starting with # are skipped
+static bool loadGoldenRuns(const std::string& filename, std::vector<GoldenRun>& runs)
+{
+    std::ifstream infile(filename);
+    if (!infile.is_open())
+    {
+        std::cerr << "Unable to open golden file: " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(infile, line))
+    {
+        line_number++;
+        std::istringstream words(line);
+        std::string term;
+        if (!(words >> term) || term[0] == '#')
+        {
+            continue;
+        }
+
+        GoldenRun run = { "", 0, 0, 50, 0, 0, 0.0, 0.25, 0, false, 0, 0.0, 0 };
+        do
+        {
+            size_t split = term.find('=');
+            if (split == std::string::npos || !setGoldenField(run, term.substr(0, split), term.substr(split + 1)))
+            {
+                std::cerr << "Golden file line " << line_number << ": cannot use " << term << std::endl;
+                return false;
+            }
+        } while (words >> term);
+
+        if (run.backend.empty() || run.frame_width <= 0 || run.frame_height <= 0 || run.generations <= 0)
+        {
+            std::cerr << "Golden file line " << line_number << ": needs backend, frame_width, frame_height and generations" << std::endl;
+            return false;
+        }
+        runs.push_back(run);
+    }
+    return true;
+}
+
+// Keeps the tolerances and replaces the golden values by the measured ones
+static bool saveGoldenRuns(const std::string& filename, const std::vector<GoldenRun>& runs)
+{
+    std::ofstream outfile(filename);
+    if (!outfile.is_open())
+    {
+        std::cerr << "Unable to write golden file: " << filename << std::endl;
+        return false;
+    }
+    outfile << "# Golden runs of sofa-golden, rewritten by sofa-golden --update [--gl]." << std::endl;
+    outfile << "# Throughput and peak RSS depend on the machine, record them where the runs are compared." << std::endl;
+    for (const GoldenRun& run : runs)
+    {
+        outfile << "backend=" << run.backend << " frame_width=" << run.frame_width << " frame_height=" << run.frame_height
+            << " generations=" << run.generations
+            << " score=" << (run.measured ? run.measured_score : run.score) << " score_tolerance=" << run.score_tolerance
+            << " evaluations_per_second=" << (run.measured ? run.measured_evaluations_per_second : run.evaluations_per_second)
+            << " throughput_tolerance=" << run.throughput_tolerance
+            << " peak_rss_kb=" << (run.measured ? run.measured_peak_rss_kb : run.peak_rss_kb) << std::endl;
+    }
+    return (bool)outfile;
+}
+
+// Writing 5 to clear_refs resets the peak, where that is not allowed the peak covers the whole process
+static void resetPeakRss()
+{
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+static long readPeakRssKb()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return atol(line.c_str() + 6);
+        }
+    }
+    return 0;
+}
+
+// The generational loop of the main program, without cache, archive or checkpoints
+static int optimize(const GoldenRun& run, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence,
+    const std::function<int(const std::vector<double>&, const std::vector<glm::vec3>&)>& evaluate, long long& evaluations)
+{
+    Optimizer optimizer(time_resolution, yaw_sequence, offset_sequence, population_amount, surviver_amount, basis_size, seed);
+    std::vector<std::vector<double>> yaw_sequences;
+    std::vector<std::vector<glm::vec3>> offset_sequences;
+    std::vector<int> scores;
+    evaluations = 0;
+    for (int g = 0; g < run.generations; g++)
+    {
+        optimizer.loadPopulation(yaw_sequences, offset_sequences);
+        scores.resize(yaw_sequences.size());
+        for (size_t j = 0; j < yaw_sequences.size(); j++)
+        {
+            scores[j] = evaluate(yaw_sequences[j], offset_sequences[j]);
+            evaluations++;
+        }
+        optimizer.setPopulationScores(scores);
+        optimizer.inflatePopulation();
+    }
+    return optimizer.getBestScore();
+}
+
+static bool measureGoldenRun(GoldenRun& run, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence)
+{
+    resetPeakRss();
+    auto start = std::chrono::steady_clock::now();
+    long long evaluations = 0;
+
+    if (run.backend == "cpu")
+    {
+        CpuRasterizer rasterizer(run.frame_width, run.frame_height);
+        run.measured_score = optimize(run, yaw_sequence, offset_sequence, [&](const std::vector<double>& yaws, const std::vector<glm::vec3>& offsets)
+        {
+            return rasterizer.Render(time_resolution, anchor, yaws, offsets);
+        }, evaluations);
+    }
+    else if (run.backend == "soft")
+    {
+        SoftRasterizer rasterizer(run.frame_width, run.frame_height, soft_threads);
+        run.measured_score = optimize(run, yaw_sequence, offset_sequence, [&](const std::vector<double>& yaws, const std::vector<glm::vec3>& offsets)
+        {
+            return (int)std::lround(rasterizer.Render(time_resolution, anchor, yaws, offsets));
+        }, evaluations);
+    }
+    else if (run.backend == "gl")
+    {
+        GlEvaluatorContext gl;
+        if (!createGlEvaluatorContext("sofa-golden", run.frame_width, run.frame_height, gl))
+        {
+            return false;
+        }
+        Renderer renderer(run.frame_width, run.frame_height, gl.window, gl.program);
+        run.measured_score = optimize(run, yaw_sequence, offset_sequence, [&](const std::vector<double>& yaws, const std::vector<glm::vec3>& offsets)
+        {
+            return renderer.Render(time_resolution, anchor, yaws, offsets);
+        }, evaluations);
+        destroyGlEvaluatorContext(gl);
+    }
+    else
+    {
+        std::cerr << "Unknown backend in golden file: " << run.backend << std::endl;
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.measured_evaluations_per_second = evaluations / seconds;
+    run.measured_peak_rss_kb = readPeakRssKb();
+    run.measured = true;
+    return true;
+}
+
+// Runs a fixed-seed, fixed-budget optimization from Hammersley's sofa (or --motion) on every
+// backend of the golden file and compares the final score and the throughput with the golden
+// values. Exits with 1 if any run regressed beyond its tolerance. --update records the
+// measured values as the new golden values instead. The GL backend needs a window and only
+// runs with --gl.
+int main(int argc, char* argv[])
+{
+    std::string golden_filename = "golden_runs.txt";
+    std::string motion_filename;
+    std::string only_backend;
+    bool update = false;
+    bool gl = false;
+    for (int a = 1; a < argc; a++)
+    {
+        std::string argument = argv[a];
+        if (argument == "--golden" && a + 1 < argc)
+        {
+            golden_filename = argv[++a];
+        }
+        else if (argument == "--motion" && a + 1 < argc)
+        {
+            motion_filename = argv[++a];
+        }
+        else if (argument == "--backend" && a + 1 < argc)
+        {
+            only_backend = argv[++a];
+        }
+        else if (argument == "--update")
+        {
+            update = true;
+        }
+        else if (argument == "--gl")
+        {
+            gl = true;
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--golden golden_runs.txt] [--motion motion.bin] [--backend cpu|soft|gl] [--update] [--gl]" << std::endl;
+            return -1;
+        }
+    }
+
+    std::vector<GoldenRun> runs;
+    if (!loadGoldenRuns(golden_filename, runs))
+    {
+        return -1;
+    }
+
+    std::vector<double> yaw_sequence;
+    std::vector<glm::vec3> offset_sequence;
+    if (!motion_filename.empty())
+    {
+        if (!loadMotionFile(motion_filename, time_resolution, yaw_sequence, offset_sequence))
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        buildSeedMotion(SEED_MOTION_HAMMERSLEY, time_resolution, yaw_sequence, offset_sequence);
+    }
+
+    bool regressed = false;
+    for (GoldenRun& run : runs)
+    {
+        if ((!only_backend.empty() && run.backend != only_backend) || (run.backend == "gl" && !gl))
+        {
+            continue;
+        }
+        if (!measureGoldenRun(run, yaw_sequence, offset_sequence))
+        {
+            return -1;
+        }
+
+        bool score_ok = std::abs(run.measured_score - run.score) <= run.score_tolerance;
+        bool throughput_ok = run.measured_evaluations_per_second >= run.evaluations_per_second * (1.0 - run.throughput_tolerance);
+        std::cout << run.backend << " " << run.frame_width << "x" << run.frame_height << " " << run.generations << " generations:"
+            << " score " << run.measured_score << " (golden " << run.score << " +-" << run.score_tolerance << ")"
+            << " evaluations/s " << run.measured_evaluations_per_second << " (golden " << run.evaluations_per_second << " -" << run.throughput_tolerance * 100.0 << "%)"
+            << " peak RSS " << run.measured_peak_rss_kb << " kB";
+        if (!update && run.evaluations_per_second <= 0.0)
+        {
+            std::cout << " no golden values recorded yet, see --update";
+        }
+        else if (!update)
+        {
+            std::cout << (score_ok ? "" : " SCORE REGRESSION") << (throughput_ok ? "" : " THROUGHPUT REGRESSION");
+            regressed = regressed || !score_ok || !throughput_ok;
+        }
+        std::cout << std::endl;
+    }
+
+    if (update)
+    {
+        return saveGoldenRuns(golden_filename, runs) ? 0 : -1;
+    }
+    return regressed ? 1 : 0;
+}
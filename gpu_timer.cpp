@@ -0,0 +1,149 @@
+#include "gpu_timer.h"
+
+#include <algorithm>
+
+#include "trace.h"
+
+static const char* stage_names[GPU_STAGE_AMOUNT] = { "gpu/clear", "gpu/draw", "gpu/swap", "gpu/readback" };
+
+GpuTimer::GpuTimer(int latency)
+: available(false), next(0), resolved_amount(0), skipped_amount(0)
+{
+    for (int s = 0; s < GPU_STAGE_AMOUNT; s++)
+    {
+        stage_seconds[s] = 0.0;
+    }
+
+    GLint counter_bits = 0;
+    if (GLEW_ARB_timer_query)
+    {
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counter_bits);
+    }
+    if (counter_bits == 0)
+    {
+        std::cerr << "GL timer queries are unavailable, running without GPU timing" << std::endl;
+        return;
+    }
+    available = true;
+
+    sets.resize(std::max(latency, 2));
+    for (QuerySet& set : sets)
+    {
+        glGenQueries(GPU_STAGE_AMOUNT + 1, set.queries);
+        set.pending = false;
+    }
+
+    if (tracing_enabled.load())
+    {
+        GLint64 gpu_now = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+        setGpuTraceClock((uint64_t)gpu_now, readTraceClock());
+    }
+}
+
+GpuTimer::~GpuTimer()
+{
+    for (QuerySet& set : sets)
+    {
+        glDeleteQueries(GPU_STAGE_AMOUNT + 1, set.queries);
+    }
+}
+
+bool GpuTimer::isAvailable()
+{
+    return available;
+}
+
+void GpuTimer::beginEvaluation()
+{
+    if (!available)
+    {
+        return;
+    }
+    poll();
+    if (sets[next].pending)
+    {
+        sets[next].pending = false;
+        skipped_amount++;
+    }
+    glQueryCounter(sets[next].queries[0], GL_TIMESTAMP);
+}
+
+void GpuTimer::endStage(GpuTimerStage stage)
+{
+    if (available)
+    {
+        glQueryCounter(sets[next].queries[stage + 1], GL_TIMESTAMP);
+    }
+}
+
+void GpuTimer::endEvaluation()
+{
+    if (!available)
+    {
+        return;
+    }
+    sets[next].pending = true;
+    next = (next + 1) % sets.size();
+}
+
+bool GpuTimer::collect(QuerySet& set)
+{
+    // The last timestamp is the last to become available
+    GLint ready = GL_FALSE;
+    glGetQueryObjectiv(set.queries[GPU_STAGE_AMOUNT], GL_QUERY_RESULT_AVAILABLE, &ready);
+    if (ready != GL_TRUE)
+    {
+        return false;
+    }
+
+    GLuint64 timestamps[GPU_STAGE_AMOUNT + 1];
+    for (int q = 0; q <= GPU_STAGE_AMOUNT; q++)
+    {
+        glGetQueryObjectui64v(set.queries[q], GL_QUERY_RESULT, &timestamps[q]);
+    }
+    for (int s = 0; s < GPU_STAGE_AMOUNT; s++)
+    {
+        uint64_t begin = timestamps[s];
+        uint64_t end = std::max(timestamps[s + 1], timestamps[s]);
+        stage_seconds[s] += (end - begin) * 1e-9;
+        recordGpuTraceEvent(stage_names[s], begin, end);
+    }
+    set.pending = false;
+    resolved_amount++;
+    return true;
+}
+
+void GpuTimer::poll()
+{
+    if (!available)
+    {
+        return;
+    }
+    // Oldest first, results of a later set are never ready before those of an earlier one
+    for (size_t i = 0; i < sets.size(); i++)
+    {
+        QuerySet& set = sets[(next + i) % sets.size()];
+        if (set.pending && !collect(set))
+        {
+            break;
+        }
+    }
+}
+
+void GpuTimer::printSummary(const std::string& label, std::ostream& output)
+{
+    if (!available)
+    {
+        return;
+    }
+    output << label << " GPU";
+    for (int s = 0; s < GPU_STAGE_AMOUNT; s++)
+    {
+        output << " " << (stage_names[s] + 4) << " " << (resolved_amount > 0 ? stage_seconds[s] * 1e3 / resolved_amount : 0.0) << " ms";
+        stage_seconds[s] = 0.0;
+    }
+    output << " over " << resolved_amount << " evaluations, " << skipped_amount << " skipped" << std::endl;
+    resolved_amount = 0;
+    skipped_amount = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+// Parts of one GL evaluation, each ends at a GPU timestamp
+enum GpuTimerStage
+{
+    GPU_STAGE_CLEAR = 0,
+    GPU_STAGE_DRAW = 1,
+    GPU_STAGE_SWAP = 2,
+    GPU_STAGE_READBACK = 3,
+    GPU_STAGE_AMOUNT = 4
+};
+
+// GPU side timing of Renderer::Render with GL_TIMESTAMP queries. Every
+// evaluation writes a timestamp before the clear and after each stage into
+// one of latency query sets. Results are only collected once the driver
+// reports them available, a few evaluations later, so the queries never
+// wait on the GPU. A set that is still pending when its turn comes again is
+// overwritten and counted as skipped. Collected stages also go to the trace
+// as spans on a GPU track, next to the CPU spans.
+class GpuTimer
+{
+    private:
+    struct QuerySet
+    {
+        GLuint queries[GPU_STAGE_AMOUNT + 1];
+        bool pending;
+    };
+
+    bool available;
+    std::vector<QuerySet> sets;
+    // Set the next evaluation writes to, the oldest pending set follows it
+    size_t next;
+
+    double stage_seconds[GPU_STAGE_AMOUNT];
+    long long resolved_amount;
+    long long skipped_amount;
+
+    bool collect(QuerySet& set);
+
+    protected:
+    public:
+    // Needs a current GL context, without timer queries every call is a no-op
+    GpuTimer(int latency = 4);
+    ~GpuTimer();
+    bool isAvailable();
+    void beginEvaluation();
+    void endStage(GpuTimerStage stage);
+    void endEvaluation();
+    // Collects every set whose results are ready, without waiting
+    void poll();
+    // Mean GPU milliseconds per stage of the evaluations collected since the last call
+    void printSummary(const std::string& label, std::ostream& output);
+};
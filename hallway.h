@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+// Axis aligned wall rectangle of the hallway in model space
+struct WallRect
+{
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+};
+
+const int hallway_wall_amount = 3;
+
+const WallRect hallway_walls[hallway_wall_amount] =
+{
+    { -10.0f, -10.0f, 0.0f, 0.0f },
+    { -10.0f, 0.5f, 0.5f, 10.0f },
+    { 0.5f, -10.0f, 10.0f, 10.0f }
+};
+
+// Two triangles per wall, three floats per vertex
+inline std::vector<float> buildHallwayVertices()
+{
+    std::vector<float> vertices;
+    for (int i = 0; i < hallway_wall_amount; i++)
+    {
+        const WallRect& wall = hallway_walls[i];
+        float corners[6][2] =
+        {
+            { wall.min_x, wall.min_y },
+            { wall.min_x, wall.max_y },
+            { wall.max_x, wall.max_y },
+            { wall.max_x, wall.max_y },
+            { wall.max_x, wall.min_y },
+            { wall.min_x, wall.min_y }
+        };
+        for (int j = 0; j < 6; j++)
+        {
+            vertices.push_back(corners[j][0]);
+            vertices.push_back(corners[j][1]);
+            vertices.push_back(0.0f);
+        }
+    }
+    return vertices;
+}
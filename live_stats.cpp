@@ -0,0 +1,217 @@
+#include "live_stats.h"
+
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char live_stats_magic[8] = { 'S', 'O', 'F', 'A', 'L', 'I', 'V', 'E' };
+static const uint32_t live_stats_version = 1;
+static const char* phase_names[LIVE_PHASE_AMOUNT] = { "breed", "evaluate", "select" };
+
+static uint64_t monotonicNanoseconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+LiveStats::LiveStats()
+: block(nullptr)
+{
+
+}
+
+LiveStats::~LiveStats()
+{
+    if (block)
+    {
+        munmap(block, sizeof(LiveStatsBlock));
+        shm_unlink(name.c_str());
+    }
+}
+
+// True if the segment holds a block whose run has exited, e.g. one that crashed before unlinking it
+static bool isAbandoned(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    bool abandoned = false;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(LiveStatsBlock))
+    {
+        void* mapping = mmap(nullptr, sizeof(LiveStatsBlock), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            const LiveStatsBlock* block = static_cast<const LiveStatsBlock*>(mapping);
+            abandoned = memcmp(block->magic, live_stats_magic, sizeof(live_stats_magic)) == 0 && kill((pid_t)block->pid, 0) != 0 && errno == ESRCH;
+            munmap(mapping, sizeof(LiveStatsBlock));
+        }
+    }
+    close(fd);
+    return abandoned;
+}
+
+// Creates the segment, never one another process still uses
+static int createSegment(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST && isAbandoned(name))
+    {
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    return fd;
+}
+
+bool LiveStats::open(const std::string& name, int worker_amount)
+{
+    // Concurrent runs each get their own block, the later ones under a name with their pid
+    std::string segment_name = name;
+    int fd = createSegment(segment_name);
+    if (fd < 0 && errno == EEXIST)
+    {
+        segment_name = name + "-" + std::to_string(getpid());
+        fd = createSegment(segment_name);
+        if (fd >= 0)
+        {
+            std::cout << "Live statistics segment " << name << " is in use, watch this run with sofa-top --name " << segment_name << std::endl;
+        }
+    }
+    if (fd < 0)
+    {
+        std::cerr << "Unable to create live statistics segment " << segment_name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, sizeof(LiveStatsBlock)) != 0)
+    {
+        std::cerr << "Unable to size live statistics segment " << segment_name << ": " << strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(segment_name.c_str());
+        return false;
+    }
+    void* mapping = mmap(nullptr, sizeof(LiveStatsBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Unable to map live statistics segment " << segment_name << ": " << strerror(errno) << std::endl;
+        shm_unlink(segment_name.c_str());
+        return false;
+    }
+
+    // A new segment is zeroed, which is a valid state for every atomic
+    this->name = segment_name;
+    block = static_cast<LiveStatsBlock*>(mapping);
+    block->version = live_stats_version;
+    block->block_size = sizeof(LiveStatsBlock);
+    block->pid = getpid();
+    block->start_nanoseconds = monotonicNanoseconds();
+    block->worker_amount.store(worker_amount, std::memory_order_relaxed);
+    block->best_score.store(0, std::memory_order_relaxed);
+    touch();
+    // Readers check the magic last, after everything above is in place
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(block->magic, live_stats_magic, sizeof(live_stats_magic));
+    return true;
+}
+
+void LiveStats::touch()
+{
+    block->updated_nanoseconds.store(monotonicNanoseconds(), std::memory_order_relaxed);
+}
+
+void LiveStats::setGeneration(int generation)
+{
+    if (block)
+    {
+        block->generation.store(generation, std::memory_order_relaxed);
+        touch();
+    }
+}
+
+void LiveStats::recordEvaluation(int best_score, bool improved, bool cache_hit, double evaluator_seconds)
+{
+    if (!block)
+    {
+        return;
+    }
+    block->best_score.store(best_score, std::memory_order_relaxed);
+    block->evaluations.fetch_add(1, std::memory_order_relaxed);
+    if (improved)
+    {
+        block->improvements.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (cache_hit)
+    {
+        block->cache_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    block->busy_nanoseconds.fetch_add((uint64_t)(evaluator_seconds * 1e9), std::memory_order_relaxed);
+    touch();
+}
+
+void LiveStats::recordPhase(LivePhase phase, double seconds)
+{
+    if (!block)
+    {
+        return;
+    }
+    uint64_t microseconds = (uint64_t)(seconds * 1e6);
+    int bucket = 0;
+    while (bucket + 1 < live_histogram_buckets && microseconds >= (2ull << bucket))
+    {
+        bucket++;
+    }
+    block->histograms[phase][bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+const LiveStatsBlock* attachLiveStats(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        std::cerr << "No live statistics segment " << name << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(LiveStatsBlock))
+    {
+        std::cerr << "Live statistics segment " << name << " is not ready yet" << std::endl;
+        close(fd);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, sizeof(LiveStatsBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Unable to map live statistics segment " << name << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    const LiveStatsBlock* block = static_cast<const LiveStatsBlock*>(mapping);
+    bool valid = memcmp(block->magic, live_stats_magic, sizeof(live_stats_magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid || block->version != live_stats_version || block->block_size != sizeof(LiveStatsBlock))
+    {
+        std::cerr << "Live statistics segment " << name << " is not ready or of another version" << std::endl;
+        munmap(mapping, sizeof(LiveStatsBlock));
+        return nullptr;
+    }
+    return block;
+}
+
+void detachLiveStats(const LiveStatsBlock* block)
+{
+    munmap(const_cast<LiveStatsBlock*>(block), sizeof(LiveStatsBlock));
+}
+
+const char* getLivePhaseName(LivePhase phase)
+{
+    return phase_names[phase];
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// Phases with a latency histogram in the statistics block
+enum LivePhase
+{
+    LIVE_PHASE_BREED = 0,
+    LIVE_PHASE_EVALUATE = 1,
+    LIVE_PHASE_SELECT = 2,
+    LIVE_PHASE_AMOUNT = 3
+};
+
+// Bucket b counts latencies in [2^b, 2^(b+1)) microseconds, the last one everything above
+const int live_histogram_buckets = 32;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the statistics block needs lock-free 64 bit atomics");
+
+// Layout of the shared memory segment. Only plain lock-free atomics, so a
+// reader in another process sees every field whole without any locking.
+struct LiveStatsBlock
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t block_size;
+    int64_t pid;
+    // CLOCK_MONOTONIC, the same clock in every process of the machine
+    uint64_t start_nanoseconds;
+    std::atomic<uint64_t> updated_nanoseconds;
+
+    std::atomic<int64_t> generation;
+    std::atomic<int64_t> best_score;
+    std::atomic<uint64_t> evaluations;
+    std::atomic<uint64_t> cache_hits;
+    // Evaluations that raised the best score
+    std::atomic<uint64_t> improvements;
+
+    // Evaluator time summed over all workers, utilization is its rate over worker_amount
+    std::atomic<uint64_t> worker_amount;
+    std::atomic<uint64_t> busy_nanoseconds;
+
+    std::atomic<uint64_t> histograms[LIVE_PHASE_AMOUNT][live_histogram_buckets];
+};
+
+// Writer side of the statistics block that sofa-top displays. Every update is
+// a relaxed atomic store or add into the mapped segment, so the run never
+// formats, prints or waits for a reader. The writer only ever uses a segment
+// it created itself and removes it when it is destroyed.
+class LiveStats
+{
+    private:
+    std::string name;
+    LiveStatsBlock* block;
+
+    void touch();
+
+    protected:
+    public:
+    LiveStats();
+    ~LiveStats();
+    // POSIX shared memory name, e.g. /sofa-stats. If another live run holds it, the pid is appended.
+    bool open(const std::string& name, int worker_amount);
+    void setGeneration(int generation);
+    // One scored candidate, evaluator_seconds is 0 for cache hits
+    void recordEvaluation(int best_score, bool improved, bool cache_hit, double evaluator_seconds);
+    void recordPhase(LivePhase phase, double seconds);
+};
+
+// Maps an existing block read-only, returns nullptr with a message if there is none or it is of another version
+const LiveStatsBlock* attachLiveStats(const std::string& name);
+void detachLiveStats(const LiveStatsBlock* block);
+const char* getLivePhaseName(LivePhase phase);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded multi-producer multi-consumer queue after Dmitry Vyukov. Every cell
+// carries a sequence number that tells producers and consumers whose turn it
+// is, so push and pop only need one compare-and-swap on their own index.
+template <typename T>
+class LockFreeQueue
+{
+    private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::vector<Cell> cells;
+    size_t mask;
+
+    static size_t roundCapacity(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        return size;
+    }
+
+    alignas(64) std::atomic<size_t> enqueue_position;
+    alignas(64) std::atomic<size_t> dequeue_position;
+
+    protected:
+    public:
+    // The capacity is rounded up to a power of two
+    LockFreeQueue(size_t capacity)
+    : cells(roundCapacity(capacity)), mask(roundCapacity(capacity) - 1), enqueue_position(0), dequeue_position(0)
+    {
+        for (size_t i = 0; i < cells.size(); i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const T& value)
+    {
+        size_t position = enqueue_position.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0)
+            {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T& value)
+    {
+        size_t position = dequeue_position.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+            if (difference == 0)
+            {
+                if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.value);
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
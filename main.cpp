@@ -2,6 +2,10 @@
 #include <vector>
 #include <ctime>
 #include <cmath>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <memory>
 
 #include <SDL2/SDL.h>
 #include <GL/glew.h>
@@ -12,15 +16,124 @@
 #include "libs/glm/gtc/type_ptr.hpp"
 
 #include "util.h"
+#include "hallway.h"
 #include "renderer.h"
 #include "optimizer.h"
+#include "fitness_cache.h"
+#include "steady_state.h"
+#include "multi_fidelity.h"
+#include "sweep.h"
+#include "polisher.h"
+#include "parallel_tempering.h"
+#include "checkpoint.h"
+#include "seed_motions.h"
+#include "motion_file.h"
+#include "telemetry.h"
+#include "candidate_archive.h"
+#include "shader_program.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "gpu_timer.h"
+#include "live_stats.h"
 
 const int frame_width = 1400;
 const int frame_height = 1400;
 const int time_resolution = 1000;
+// Best motion so far, read at startup and rewritten whenever a run improves it
+const std::string motion_filename = "motion.bin";
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Command line switches
+    bool steady_state = false;
+    bool resume = false;
+    bool multi_fidelity = false;
+    bool polish = false;
+    bool tempering = false;
+    bool perf_counters = false;
+    bool gpu_timers = false;
+    SeedMotion seed_motion = SEED_MOTION_FILE;
+    std::string sweep_filename;
+    // Chrome trace of the spans below, written at exit
+    std::string trace_filename;
+    // Shared memory block that sofa-top attaches to
+    std::string stats_name = "/sofa-stats";
+    int worker_amount = std::max(1, (int)std::thread::hardware_concurrency());
+    for (int a = 1; a < argc; a++)
+    {
+        std::string argument = argv[a];
+        if (argument == "--steady-state")
+        {
+            steady_state = true;
+        }
+        else if (argument == "--multi-fidelity")
+        {
+            multi_fidelity = true;
+        }
+        else if (argument == "--sweep" && a + 1 < argc)
+        {
+            sweep_filename = argv[++a];
+        }
+        else if (argument == "--polish")
+        {
+            polish = true;
+        }
+        else if (argument == "--tempering")
+        {
+            tempering = true;
+        }
+        else if (argument == "--seed-motion" && a + 1 < argc)
+        {
+            if (!parseSeedMotion(argv[++a], seed_motion))
+            {
+                return -1;
+            }
+        }
+        else if (argument == "--trace" && a + 1 < argc)
+        {
+            trace_filename = argv[++a];
+        }
+        else if (argument == "--stats-name" && a + 1 < argc)
+        {
+            stats_name = argv[++a];
+        }
+        else if (argument == "--gpu-timers")
+        {
+            gpu_timers = true;
+        }
+        else if (argument == "--perf-counters")
+        {
+            perf_counters = true;
+        }
+        else if (argument == "--resume")
+        {
+            // Only the generational loop writes checkpoints, the other modes cannot resume
+            resume = true;
+        }
+        else if (argument == "--workers" && a + 1 < argc)
+        {
+            worker_amount = atoi(argv[++a]);
+        }
+    }
+
+    if (resume && (steady_state || multi_fidelity || polish || tempering || !sweep_filename.empty()))
+    {
+        std::cerr << "--resume only continues the generational loop, this mode writes no checkpoints" << std::endl;
+        return 1;
+    }
+
+    if (!trace_filename.empty())
+    {
+        enableTracing();
+        setTraceThreadName("main");
+    }
+    // Without perf events, e.g. in a container, the run goes on without counters
+    if (perf_counters)
+    {
+        perf_counters = enablePerfCounters();
+    }
+    PerfSummary perf_summary;
+
     if (SDL_Init(SDL_INIT_VIDEO) != 0)
     {
         std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
@@ -43,54 +156,20 @@ int main()
         return -1;
     }
 
-    const char* vertexShaderSource = readShaderFromFile("shaders/vertex_shader.glsl");
-    const char* fragmentShaderSource = readShaderFromFile("shaders/fragment_shader.glsl");
-
-    // Compile and link the shaders
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    float vertices[] = 
+    GLuint shaderProgram = buildShaderProgram("shader_cache.bin");
+    if (!shaderProgram)
     {
-        -10.0f, -10.0f, 0.0f,
-        -10.0f, 0.0f, 0.0f,
-        0.0f, 0.0f, 0.0f,
-
-        0.0f, 0.0f, 0.0f,
-        0.0f, -10.0f, 0.0f,
-        -10.0f, -10.0f, 0.0f,
-
-        -10.0f, 0.5f, 0.0f,
-        -10.0f, 10.0f, 0.0f,
-        0.5f, 10.0f, 0.0f,
-
-        0.5f, 10.0f, 0.0f,
-        0.5f, 0.5f, 0.0f,
-        -10.0f, 0.5f, 0.0f,
-
-        0.5f, 10.0f, 0.0f,
-        10.0f, 10.0f, 0.0f,
-        10.0f, -10.0f, 0.0f,
+        return -1;
+    }
 
-        10.0f, -10.0f, 0.0f,
-        0.5f, -10.0f, 0.0f,
-        0.5f, 10.0f, 0.0f
-    };
+    std::vector<float> vertices = buildHallwayVertices();
 
     GLuint VAO, VBO;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
@@ -127,6 +206,37 @@ int main()
     glUseProgram(shaderProgram);
     glBindVertexArray(VAO);
 
+    // GPU side stage times of the GL renderer, read back a few evaluations late
+    std::unique_ptr<GpuTimer> gpu_timer;
+    if (gpu_timers)
+    {
+        gpu_timer.reset(new GpuTimer());
+    }
+
+    auto cleanup = [&]()
+    {
+        // Timestamps still in flight are collected so the trace has them
+        if (gpu_timer)
+        {
+            glFinish();
+            gpu_timer->poll();
+        }
+
+        if (!trace_filename.empty())
+        {
+            writeTrace(trace_filename);
+        }
+
+        gpu_timer.reset();
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteProgram(shaderProgram);
+
+        SDL_GL_DeleteContext(glContext);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+    };
+
     /*Uint32 start_time = SDL_GetTicks();
     Uint32 current_time = SDL_GetTicks();
 
@@ -142,84 +252,338 @@ int main()
 
     // std::vector<double> yaw_sequence = linspace(degrees_to_radians(0.0), degrees_to_radians(90.0), time_resolution);
     // std::vector<glm::vec3> offset_sequence = linspace_vec3(offset_start, offset_end, time_resolution);
-    std::vector<double> yaw_sequence = loadYawVectorFromFile("yaw_sequence.txt");
-    std::vector<glm::vec3> offset_sequence = loadOffsetVectorFromFile("offset_sequence.txt");
+    std::vector<double> yaw_sequence;
+    std::vector<glm::vec3> offset_sequence;
+    if (seed_motion == SEED_MOTION_FILE)
+    {
+        // Motions from before the motion file format are still read once, at any resolution
+        if (!loadMotionFile(motion_filename, time_resolution, yaw_sequence, offset_sequence))
+        {
+            yaw_sequence = loadYawVectorFromFile("yaw_sequence.txt");
+            offset_sequence = loadOffsetVectorFromFile("offset_sequence.txt");
+            if (!yaw_sequence.empty() && offset_sequence.size() == yaw_sequence.size())
+            {
+                resampleMotion(time_resolution, yaw_sequence, offset_sequence);
+            }
+        }
+        // A fresh run without motion files starts from Hammersley's sofa
+        if (yaw_sequence.empty() || offset_sequence.size() != yaw_sequence.size())
+        {
+            seed_motion = SEED_MOTION_HAMMERSLEY;
+        }
+    }
+    if (seed_motion != SEED_MOTION_FILE)
+    {
+        buildSeedMotion(seed_motion, time_resolution, yaw_sequence, offset_sequence);
+        std::cout << "Seed motion " << getSeedMotionName(seed_motion) << " expected Pixel " << areaToPixel(getSeedMotionArea(seed_motion), frame_width, frame_height) << std::endl;
+    }
+    std::cout << "Gerver's sofa would leave " << areaToPixel(gerver_area, frame_width, frame_height) << " Pixel" << std::endl;
 
     int population_amount = 10;
-    int surviver_amount = 1;
+    int surviver_amount = 3;
+    // Spline control points per channel, 0 searches the raw per-frame samples
+    int basis_size = 32;
+    // Seed of all random streams, the same seed reproduces a run exactly
+    uint64_t seed = 1;
 
     Renderer renderer(frame_width, frame_height, window, shaderProgram);
+    renderer.setGpuTimer(gpu_timer.get());
+
+    Optimizer optimizer(time_resolution, yaw_sequence, offset_sequence, population_amount, surviver_amount, basis_size, seed);
+    // Breed this many children per slot and only render the ones the surrogate ranks best
+    optimizer.setSurrogateOversampling(20);
+    // Learn separate step sizes for ten time regions, continue from the last run if possible
+    optimizer.setStepSizeRegions(10);
+    optimizer.loadStepSizeFromFile("step_size.txt");
+    // Half of the bumps are centered on frames that bind the best survivor, found at a quarter of the resolution
+    optimizer.setGuidedProposals(0.5, frame_width / 4, frame_height / 4, anchor);
+
+    int generations = 1000;
+
+    // One binary record per evaluation, decode with sofa-telemetry
+    TelemetryLogger telemetry("telemetry.bin");
+
+    // Watch the run with sofa-top, the generational loop renders on this thread alone
+    LiveStats live_stats;
+    live_stats.open(stats_name, steady_state && !multi_fidelity ? worker_amount : 1);
 
-    Optimizer optimizer(time_resolution, yaw_sequence, offset_sequence, population_amount, surviver_amount);
+    // Every scored candidate as parent ids plus mutation parameters, kept across runs
+    CandidateArchive archive(time_resolution, basis_size);
+    if (archive.openForAppend("archive.bin"))
+    {
+        optimizer.setArchive(&archive);
+    }
+
+    if (polish)
+    {
+        // Line searches on the frames that bind the boundary, every probe is scored incrementally
+        Polisher polisher(frame_width, frame_height, anchor);
+        int remaining_pixel = polisher.polish(yaw_sequence, offset_sequence, 200);
+        std::cout << "Polished Pixel " << remaining_pixel << " with " << polisher.getProbeAmount() << " probes" << std::endl;
+
+        saveMotionFile(motion_filename, polisher.getYawSequence(), polisher.getOffsetSequence(), MOTION_PRECISION_DOUBLE);
+
+        cleanup();
+        return 0;
+    }
+
+    if (tempering)
+    {
+        // One chain per worker, temperatures in pixels from small steps back to large detours
+        EvaluatorPool pool(worker_amount, frame_width, frame_height, time_resolution, anchor);
+        pool.setTelemetry(&telemetry);
+        ParallelTempering replicas(optimizer, pool, optimizer.createIndividual(yaw_sequence, offset_sequence), worker_amount, 20.0, 20000.0, seed);
+        replicas.run(generations * population_amount / worker_amount);
+
+        std::cout << "Parallel tempering best " << replicas.getBest().score << std::endl;
+        saveMotionFile(motion_filename, replicas.getBest().yaw_sequence, replicas.getBest().offset_sequence, MOTION_PRECISION_DOUBLE);
+
+        cleanup();
+        return 0;
+    }
+
+    if (!sweep_filename.empty())
+    {
+        // Unset keys of the sweep file take the settings above
+        SweepConfig defaults = { population_amount, surviver_amount, generations, basis_size, 10, 20, SELECTION_PLUS, 1.0, 0.3, seed };
+        std::vector<SweepConfig> configs;
+        if (loadSweepConfigs(sweep_filename, defaults, configs))
+        {
+            SweepRunner sweep(configs, yaw_sequence, offset_sequence, worker_amount, frame_width, frame_height, time_resolution, anchor);
+            sweep.run("sweep_results.csv");
+        }
+
+        cleanup();
+        return 0;
+    }
+
+    if (steady_state || multi_fidelity)
+    {
+        // CPU workers replace the GL renderer, so their scores go to their own cache
+        EvaluatorConfig cpu_config = { frame_width, frame_height, time_resolution, BACKEND_CPU };
+        FitnessCache cpu_cache(cpu_config);
+        cpu_cache.openFile("fitness_cache_cpu.bin", 1 << 20);
+
+        if (multi_fidelity)
+        {
+            // Rungs from an eighth of the frame size and frame count up to full fidelity, half of the candidates advance
+            MultiFidelityScheduler scheduler(optimizer, &cpu_cache, worker_amount, frame_width, frame_height, time_resolution, anchor, 4, 0.5);
+            // Same cost as the generational run, every bracket costs about two generations
+            scheduler.run(generations * population_amount, 2 * population_amount);
+
+            std::cout << "Multi-fidelity best " << optimizer.getBestScore() << " after screening " << scheduler.getScreenedAmount()
+                << " candidates for " << scheduler.getSpentUnits() << " full evaluations" << std::endl;
+        }
+        else
+        {
+            SteadyStateRunner runner(optimizer, &cpu_cache, worker_amount, frame_width, frame_height, time_resolution, anchor);
+            runner.setTelemetry(&telemetry);
+            runner.setLiveStats(&live_stats);
+            runner.run(generations * population_amount);
+
+            std::cout << "Steady state best " << optimizer.getBestScore() << " after " << runner.getElapsedSeconds() << " s, worker utilization "
+                << runner.getUtilization() * 100.0 << "%" << std::endl;
+        }
+
+        saveMotionFile(motion_filename, optimizer.getBestYawSequence(), optimizer.getBestOffsetSequence(), MOTION_PRECISION_DOUBLE);
+        optimizer.saveStepSizeToFile("step_size.txt");
+
+        // Without generations the counters are summarized once for the whole run
+        if (perf_counters)
+        {
+            takePerfSummary(perf_summary);
+            printPerfSummary(perf_summary, "Run", std::cout);
+        }
+
+        cleanup();
+        return 0;
+    }
+
+    // Scores of candidates seen before, persisted across runs
+    EvaluatorConfig evaluator_config = { frame_width, frame_height, time_resolution, BACKEND_GL };
+    FitnessCache fitness_cache(evaluator_config);
+    fitness_cache.openFile("fitness_cache.bin", 1 << 20);
 
     std::vector<std::vector<double>> yaw_sequences;
     std::vector<std::vector<glm::vec3>> offset_sequences;
     std::vector<int> population_scores(population_amount);
-
-    int generations = 1000;
+    std::vector<double> population_seconds(population_amount);
 
     std::vector<int> generation_scores(generations);
 
+    // A snapshot every checkpoint_interval generations and a journal record after every other one
+    int checkpoint_interval = 25;
+    Checkpointer checkpointer("checkpoint.bin", "checkpoint.journal");
+    int first_generation = 0;
+
+    if (resume)
+    {
+        int snapshot_generation = 0;
+        std::vector<char> snapshot;
+        std::vector<std::vector<char>> records;
+        bool resumed = checkpointer.load(snapshot_generation, snapshot, records);
+        if (resumed)
+        {
+            ByteReader reader(snapshot);
+            resumed = reader.readVector(generation_scores, generations) && (int)generation_scores.size() == generations && optimizer.loadState(reader);
+        }
+        if (!resumed)
+        {
+            std::cerr << "Unable to resume, the checkpoint was left untouched" << std::endl;
+            cleanup();
+            return 1;
+        }
+
+        first_generation = snapshot_generation;
+        for (const std::vector<char>& record : records)
+        {
+            ByteReader reader(record);
+            int32_t completed = 0;
+            int32_t score = 0;
+            if (!reader.read(completed) || !reader.read(score) || completed != first_generation + 1 || completed > generations || !optimizer.loadState(reader))
+            {
+                break;
+            }
+            generation_scores[first_generation] = score;
+            first_generation = completed;
+        }
+        std::cout << "Resuming after generation " << first_generation << " with best score " << optimizer.getBestScore() << std::endl;
+    }
+
+    // Starts a fresh journal, it also drops a torn record a crash may have left behind
+    ByteWriter initial_snapshot;
+    initial_snapshot.writeVector(generation_scores);
+    optimizer.saveState(initial_snapshot, true);
+    checkpointer.submitSnapshot(first_generation, initial_snapshot.takeBytes());
+
+    // The restored state is the one right after selection
+    if (first_generation > 0)
+    {
+        optimizer.inflatePopulation();
+    }
+    int live_best_score = optimizer.getBestScore();
+
     bool quit = false;
 
-    for (int i = 0; i < generations; i++)
+    for (int i = first_generation; i < generations; i++)
     {
-        int max_index = 0;
-        int max_value = 0;
+        TraceSpan generation_span("generation");
+        live_stats.setGeneration(i + 1);
 
         optimizer.loadPopulation(yaw_sequences, offset_sequences);
         for (int j = 0; j < population_amount; j++)
         {
-            SDL_Event event;
-            while (SDL_PollEvent(&event)) 
+            TraceSpan evaluation_span("evaluation");
+
             {
-                if (event.type == SDL_QUIT) 
+                TraceSpan span("main/poll_events");
+                SDL_Event event;
+                while (SDL_PollEvent(&event)) 
                 {
-                    quit = true;
+                    if (event.type == SDL_QUIT) 
+                    {
+                        quit = true;
+                    }
                 }
             }
 
             if (quit)
             {
-                glDeleteVertexArrays(1, &VAO);
-                glDeleteBuffers(1, &VBO);
-                glDeleteProgram(shaderProgram);
-                glDeleteShader(vertexShader);
-                glDeleteShader(fragmentShader);
-
-                SDL_GL_DeleteContext(glContext);
-                SDL_DestroyWindow(window);
-                SDL_Quit();
+                cleanup();
                 return 0;
             }
 
-            int remaining_pixel = renderer.Render(time_resolution, anchor, yaw_sequences[j], offset_sequences[j]);
-            std::cout << "Generation " << i + 1 << " Individual " << j << " Pixel " << remaining_pixel << std::endl;
+            int remaining_pixel;
+            double render_seconds = 0.0;
+            Hash128 candidate_hash;
+            bool cache_hit;
+            {
+                TraceSpan span("main/cache_lookup");
+                candidate_hash = fitness_cache.hashCandidate(yaw_sequences[j], offset_sequences[j]);
+                cache_hit = fitness_cache.lookup(candidate_hash, remaining_pixel);
+            }
+            if (!cache_hit)
+            {
+                auto render_start = std::chrono::steady_clock::now();
+                remaining_pixel = renderer.Render(time_resolution, anchor, yaw_sequences[j], offset_sequences[j]);
+                render_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - render_start).count();
+                fitness_cache.insert(candidate_hash, remaining_pixel);
+            }
+            telemetry.log(i + 1, j, remaining_pixel, render_seconds, cache_hit ? TELEMETRY_CACHE_HIT : 0);
             population_scores[j] = remaining_pixel;
+            population_seconds[j] = render_seconds;
 
-            if (remaining_pixel > max_value)
+            // An improvement beats every score seen so far, including the ones earlier in this generation
+            bool improved = remaining_pixel > live_best_score;
+            live_best_score = std::max(live_best_score, remaining_pixel);
+            if (!cache_hit)
             {
-                max_index = j;
-                max_value = remaining_pixel;
+                live_stats.recordPhase(LIVE_PHASE_EVALUATE, render_seconds);
             }
+            live_stats.recordEvaluation(live_best_score, improved, cache_hit, render_seconds);
         }
 
-        generation_scores[i] = max_value;
+        // Keep the surviver_amount best of parents and children, parents are never re-rendered
+        auto select_start = std::chrono::steady_clock::now();
+        optimizer.setPopulationScores(population_scores, population_seconds);
+        live_stats.recordPhase(LIVE_PHASE_SELECT, std::chrono::duration<double>(std::chrono::steady_clock::now() - select_start).count());
+        generation_scores[i] = optimizer.getBestScore();
+
+        const SurrogateStats& surrogate_stats = optimizer.getSurrogateStats().back();
+        std::cout << "Generation " << i + 1 << " Surrogate screened " << surrogate_stats.screened << " rendered " << surrogate_stats.evaluated
+            << " correlation " << surrogate_stats.correlation << " mean error " << surrogate_stats.mean_absolute_error << std::endl;
+
+        const StepSizeState& step_size = optimizer.getStepSizeState();
+        std::cout << "Generation " << i + 1 << " Step size amplitude " << step_size.amplitude_scale << " width " << step_size.width_fraction
+            << " success rate " << step_size.success_rate << std::endl;
+
+        if (perf_counters)
+        {
+            takePerfSummary(perf_summary);
+            printPerfSummary(perf_summary, "Generation " + std::to_string(i + 1), std::cout);
+        }
+        if (gpu_timer)
+        {
+            gpu_timer->printSummary("Generation " + std::to_string(i + 1), std::cout);
+        }
 
         // Log the score of the best and its parameter set
-        // std::string message = buildStringFromYawSequence(yaw_sequences[max_index]) + buildStringFromOffsetSequence(offset_sequences[max_index]);
+        // std::string message = buildStringFromYawSequence(optimizer.getBestYawSequence()) + buildStringFromOffsetSequence(optimizer.getBestOffsetSequence());
         // writeToLogFile(message);
 
+        // Serializing is cheap, the background thread does the writing and syncing
+        if ((i + 1) % checkpoint_interval == 0 || i + 1 == generations)
+        {
+            ByteWriter snapshot;
+            snapshot.writeVector(generation_scores);
+            optimizer.saveState(snapshot, true);
+            checkpointer.submitSnapshot(i + 1, snapshot.takeBytes());
+        }
+        else
+        {
+            ByteWriter record;
+            record.write<int32_t>(i + 1);
+            record.write<int32_t>(generation_scores[i]);
+            optimizer.saveState(record, false);
+            checkpointer.submitRecord(i + 1, record.takeBytes());
+        }
+
         if (i + 1 == generations)
         {
-            saveYawVectorToFile(yaw_sequences[max_index], "yaw_sequence.txt");
-            saveOffsetVectorToFile(offset_sequences[max_index], "offset_sequence.txt");
+            TraceSpan span("main/save_motion");
+            saveMotionFile(motion_filename, optimizer.getBestYawSequence(), optimizer.getBestOffsetSequence(), MOTION_PRECISION_DOUBLE);
+            optimizer.saveStepSizeToFile("step_size.txt");
         }
 
-        optimizer.setSurvivedIndividual(yaw_sequences[max_index], offset_sequences[max_index]);
+        auto breed_start = std::chrono::steady_clock::now();
         optimizer.inflatePopulation();
+        live_stats.recordPhase(LIVE_PHASE_BREED, std::chrono::duration<double>(std::chrono::steady_clock::now() - breed_start).count());
     }
 
+    std::cout << "Fitness cache hits " << fitness_cache.getHitCount() << " misses " << fitness_cache.getMissCount() << std::endl;
+    telemetry.close();
+    std::cout << "Telemetry records " << telemetry.getWrittenAmount() << " dropped " << telemetry.getDroppedAmount() << std::endl;
+
     for (int i = 0; i < generations; i++)
     {
         std::cout << "Score of generation " << i + 1 << " is " << generation_scores[i] << std::endl;
@@ -293,14 +657,6 @@ int main()
     // Until here it can be encapsulated
 
     // Clean up
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    SDL_GL_DeleteContext(glContext);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    cleanup();
     return 0;
 }
\ No newline at end of file
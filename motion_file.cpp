@@ -0,0 +1,236 @@
+#include "motion_file.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char motion_magic[8] = { 'S', 'O', 'F', 'A', 'M', 'O', 'T', 'N' };
+static const uint32_t motion_version = 1;
+// Reads back as 0x04030201 on a machine with the other byte order
+static const uint32_t motion_byte_order = 0x01020304;
+// Far above any resolution the renderers can hold
+static const uint64_t max_motion_frames = 1 << 24;
+
+struct MotionHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t scalar_size;
+    uint32_t crc;
+    uint64_t frame_amount;
+};
+
+template <typename T>
+static void writeColumns(ByteWriter& writer, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence)
+{
+    for (double yaw : yaw_sequence)
+    {
+        writer.write<T>((T)yaw);
+    }
+    for (int axis = 0; axis < 2; axis++)
+    {
+        for (const glm::vec3& offset : offset_sequence)
+        {
+            writer.write<T>((T)offset[axis]);
+        }
+    }
+}
+
+template <typename T>
+static void readColumns(const char* payload, size_t frame_amount, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence)
+{
+    yaw_sequence.resize(frame_amount);
+    offset_sequence.assign(frame_amount, glm::vec3(0.0f));
+    T value;
+    for (size_t i = 0; i < frame_amount; i++)
+    {
+        memcpy(&value, payload + i * sizeof(T), sizeof(T));
+        yaw_sequence[i] = value;
+    }
+    for (int axis = 0; axis < 2; axis++)
+    {
+        const char* column = payload + (axis + 1) * frame_amount * sizeof(T);
+        for (size_t i = 0; i < frame_amount; i++)
+        {
+            memcpy(&value, column + i * sizeof(T), sizeof(T));
+            offset_sequence[i][axis] = (float)value;
+        }
+    }
+}
+
+bool saveMotionFile(const std::string& filename, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence, MotionPrecision precision)
+{
+    if (yaw_sequence.size() != offset_sequence.size())
+    {
+        std::cerr << "Motion has " << yaw_sequence.size() << " yaws but " << offset_sequence.size() << " offsets" << std::endl;
+        return false;
+    }
+
+    ByteWriter payload;
+    if (precision == MOTION_PRECISION_FLOAT)
+    {
+        writeColumns<float>(payload, yaw_sequence, offset_sequence);
+    }
+    else
+    {
+        writeColumns<double>(payload, yaw_sequence, offset_sequence);
+    }
+
+    MotionHeader header;
+    memcpy(header.magic, motion_magic, sizeof(motion_magic));
+    header.version = motion_version;
+    header.byte_order = motion_byte_order;
+    header.scalar_size = precision == MOTION_PRECISION_FLOAT ? sizeof(float) : sizeof(double);
+    header.crc = computeCrc32(payload.getBytes().data(), payload.getBytes().size());
+    header.frame_amount = yaw_sequence.size();
+
+    std::string temporary_filename = filename + ".tmp";
+    std::ofstream outfile(temporary_filename, std::ios::binary | std::ios::trunc);
+    if (!outfile.is_open())
+    {
+        std::cerr << "Unable to open motion file for writing: " << temporary_filename << std::endl;
+        return false;
+    }
+    outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outfile.write(payload.getBytes().data(), payload.getBytes().size());
+    outfile.close();
+    if (!outfile || rename(temporary_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::cerr << "Unable to write motion file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadMotionFile(const std::string& filename, int time_resolution, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Unable to open motion file: " << filename << std::endl;
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(MotionHeader))
+    {
+        std::cerr << "Motion file is too short: " << filename << std::endl;
+        close(fd);
+        return false;
+    }
+    size_t size = status.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Unable to map motion file: " << filename << std::endl;
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(mapping);
+    MotionHeader header;
+    memcpy(&header, data, sizeof(header));
+    const char* payload = data + sizeof(header);
+    size_t payload_size = size - sizeof(header);
+
+    bool valid = false;
+    if (memcmp(header.magic, motion_magic, sizeof(motion_magic)) != 0)
+    {
+        std::cerr << "Not a motion file: " << filename << std::endl;
+    }
+    else if (header.byte_order != motion_byte_order)
+    {
+        std::cerr << "Motion file was written with the other byte order: " << filename << std::endl;
+    }
+    else if (header.version != motion_version)
+    {
+        std::cerr << "Motion file has unsupported version " << header.version << ": " << filename << std::endl;
+    }
+    else if ((header.scalar_size != sizeof(float) && header.scalar_size != sizeof(double))
+        || header.frame_amount == 0 || header.frame_amount > max_motion_frames
+        || payload_size != 3 * header.frame_amount * header.scalar_size)
+    {
+        std::cerr << "Motion file header does not match its size: " << filename << std::endl;
+    }
+    else if (computeCrc32(payload, payload_size) != header.crc)
+    {
+        std::cerr << "Motion file is damaged: " << filename << std::endl;
+    }
+    else
+    {
+        if (header.scalar_size == sizeof(float))
+        {
+            readColumns<float>(payload, header.frame_amount, yaw_sequence, offset_sequence);
+        }
+        else
+        {
+            readColumns<double>(payload, header.frame_amount, yaw_sequence, offset_sequence);
+        }
+        valid = true;
+    }
+    munmap(mapping, size);
+
+    if (valid && (int)yaw_sequence.size() != time_resolution)
+    {
+        std::cout << "Resampling motion from " << yaw_sequence.size() << " to " << time_resolution << " frames" << std::endl;
+        resampleMotion(time_resolution, yaw_sequence, offset_sequence);
+    }
+    return valid;
+}
+
+// Catmull-Rom segment between p1 and p2, p0 and p3 are the neighbours outside it
+template <typename T>
+static T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, double t)
+{
+    double t2 = t * t;
+    double t3 = t2 * t;
+    double w0 = 0.5 * (-t3 + 2.0 * t2 - t);
+    double w1 = 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+    double w2 = 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+    double w3 = 0.5 * (t3 - t2);
+    return p0 * (T)w0 + p1 * (T)w1 + p2 * (T)w2 + p3 * (T)w3;
+}
+
+template <typename T>
+static std::vector<T> resampleSequence(const std::vector<T>& sequence, int time_resolution)
+{
+    int frame_amount = (int)sequence.size();
+    if (frame_amount < 2 || time_resolution < 2)
+    {
+        return std::vector<T>(std::max(time_resolution, 0), sequence.empty() ? T(0) : sequence[0]);
+    }
+
+    // Frames beyond the ends continue the first and last steps linearly
+    auto sample = [&sequence, frame_amount](int i)
+    {
+        if (i < 0)
+        {
+            return sequence[0] + (sequence[0] - sequence[1]) * (T)(-i);
+        }
+        if (i >= frame_amount)
+        {
+            return sequence[frame_amount - 1] + (sequence[frame_amount - 1] - sequence[frame_amount - 2]) * (T)(i - frame_amount + 1);
+        }
+        return sequence[i];
+    };
+
+    std::vector<T> resampled(time_resolution);
+    for (int j = 0; j < time_resolution; j++)
+    {
+        double position = (double)j * (frame_amount - 1) / (time_resolution - 1);
+        int i = std::min((int)position, frame_amount - 2);
+        resampled[j] = catmullRom(sample(i - 1), sample(i), sample(i + 1), sample(i + 2), position - i);
+    }
+    return resampled;
+}
+
+void resampleMotion(int time_resolution, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence)
+{
+    yaw_sequence = resampleSequence(yaw_sequence, time_resolution);
+    offset_sequence = resampleSequence(offset_sequence, time_resolution);
+}
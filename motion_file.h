@@ -0,0 +1,28 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "libs/glm/glm.hpp"
+
+#include "serialize.h"
+
+enum MotionPrecision
+{
+    MOTION_PRECISION_FLOAT,
+    MOTION_PRECISION_DOUBLE
+};
+
+// Self describing binary motion file. A fixed header names the format version,
+// the byte order, the scalar size, the frame count and the CRC of the payload,
+// which holds the yaw column followed by the x and y offset columns. Files are
+// written to a temporary name and renamed, and read back through one mapping.
+bool saveMotionFile(const std::string& filename, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence, MotionPrecision precision);
+
+// Loads a motion and resamples it to time_resolution frames if it was saved at another resolution
+bool loadMotionFile(const std::string& filename, int time_resolution, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence);
+
+// Catmull-Rom interpolation over the frame index, the first and last frames stay in place
+void resampleMotion(int time_resolution, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence);
@@ -0,0 +1,212 @@
+#include "multi_fidelity.h"
+
+MultiFidelityScheduler::MultiFidelityScheduler(Optimizer& optimizer, FitnessCache* fitness_cache, int worker_amount, int frame_width, int frame_height, int time_resolution, glm::vec3 anchor, int rung_amount, double keep_fraction)
+: optimizer(optimizer), fitness_cache(fitness_cache), worker_amount(std::max(worker_amount, 1)), time_resolution(time_resolution), anchor(anchor),
+  keep_fraction(std::min(std::max(keep_fraction, 0.01), 1.0)), spent_seconds(0.0), screened_amount(0)
+{
+    rung_amount = std::max(rung_amount, 1);
+    for (int r = 0; r < rung_amount; r++)
+    {
+        int divisor = 1 << (rung_amount - 1 - r);
+        FidelityRung rung;
+        rung.frame_width = std::max(frame_width / divisor, 16);
+        rung.frame_height = std::max(frame_height / divisor, 16);
+        rung.frame_amount = std::max(time_resolution / divisor, 2);
+        rung.seconds_per_evaluation = 0.0;
+        rung.evaluations = 0;
+        rungs.push_back(rung);
+    }
+    rungs.back().frame_width = frame_width;
+    rungs.back().frame_height = frame_height;
+    rungs.back().frame_amount = time_resolution;
+}
+
+double MultiFidelityScheduler::rungCost(int rung)
+{
+    const FidelityRung& top = rungs.back();
+    if (rungs[rung].seconds_per_evaluation > 0.0 && top.seconds_per_evaluation > 0.0)
+    {
+        return rungs[rung].seconds_per_evaluation / top.seconds_per_evaluation;
+    }
+
+    // The CPU rasterizer works per pixel row and frame, so that is the estimate until both were measured
+    return (double)rungs[rung].frame_height * rungs[rung].frame_amount / ((double)top.frame_height * top.frame_amount);
+}
+
+std::vector<int> MultiFidelityScheduler::evaluateRung(int rung, const std::vector<Individual>& candidates, const std::vector<int>& indices, std::vector<double>& seconds)
+{
+    FidelityRung& fidelity = rungs[rung];
+    bool top = rung + 1 == (int)rungs.size();
+    std::vector<int> scores(indices.size(), 0);
+    seconds.assign(indices.size(), 0.0);
+
+    // Only full fidelity scores are comparable with the cache
+    std::vector<Hash128> hashes(indices.size());
+    std::vector<bool> cached(indices.size(), false);
+    if (top && fitness_cache)
+    {
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            const Individual& candidate = candidates[indices[i]];
+            hashes[i] = fitness_cache->hashCandidate(candidate.yaw_sequence, candidate.offset_sequence);
+            cached[i] = fitness_cache->lookup(hashes[i], scores[i]);
+        }
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<double> busy_seconds(worker_amount, 0.0);
+    std::vector<long long> evaluated(worker_amount, 0);
+    auto work = [&](int worker_id)
+    {
+        CpuRasterizer rasterizer(fidelity.frame_width, fidelity.frame_height);
+        for (size_t i = next.fetch_add(1); i < indices.size(); i = next.fetch_add(1))
+        {
+            if (cached[i])
+            {
+                continue;
+            }
+
+            const Individual& candidate = candidates[indices[i]];
+            std::vector<double> yaw_sequence = subsampleSequence(candidate.yaw_sequence, fidelity.frame_amount);
+            std::vector<glm::vec3> offset_sequence = subsampleSequence(candidate.offset_sequence, fidelity.frame_amount);
+
+            auto start = std::chrono::steady_clock::now();
+            scores[i] = rasterizer.Render((int)yaw_sequence.size(), anchor, yaw_sequence, offset_sequence);
+            seconds[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            busy_seconds[worker_id] += seconds[i];
+            evaluated[worker_id]++;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int w = 1; w < worker_amount; w++)
+    {
+        workers.push_back(std::thread(work, w));
+    }
+    work(0);
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    double rung_seconds = 0.0;
+    long long evaluation_amount = 0;
+    for (int w = 0; w < worker_amount; w++)
+    {
+        rung_seconds += busy_seconds[w];
+        evaluation_amount += evaluated[w];
+    }
+    if (evaluation_amount > 0)
+    {
+        // Running average over everything this rung evaluated
+        fidelity.seconds_per_evaluation = (fidelity.seconds_per_evaluation * fidelity.evaluations + rung_seconds) / (fidelity.evaluations + evaluation_amount);
+        fidelity.evaluations += evaluation_amount;
+    }
+    spent_seconds += rung_seconds;
+
+    if (top && fitness_cache)
+    {
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            if (!cached[i])
+            {
+                fitness_cache->insert(hashes[i], scores[i]);
+            }
+        }
+    }
+
+    return scores;
+}
+
+void MultiFidelityScheduler::run(double budget_units, double bracket_units)
+{
+    int bracket = 0;
+    while (getSpentUnits() < budget_units)
+    {
+        // Batch size that makes the whole bracket cost about bracket_units
+        double candidate_cost = 0.0;
+        double survival = 1.0;
+        for (int r = 0; r < (int)rungs.size(); r++)
+        {
+            candidate_cost += survival * rungCost(r);
+            survival *= keep_fraction;
+        }
+        int batch_amount = std::min(std::max((int)(bracket_units / candidate_cost), 1), 1 << 16);
+
+        std::vector<Individual> candidates(batch_amount);
+        std::vector<int> indices(batch_amount);
+        for (int i = 0; i < batch_amount; i++)
+        {
+            candidates[i] = optimizer.spawnCandidate();
+            indices[i] = i;
+        }
+        screened_amount += batch_amount;
+
+        for (int r = 0; r < (int)rungs.size(); r++)
+        {
+            std::vector<double> seconds;
+            std::vector<int> scores = evaluateRung(r, candidates, indices, seconds);
+
+            if (r + 1 == (int)rungs.size())
+            {
+                int best_before = optimizer.getBestScore();
+                for (size_t i = 0; i < indices.size(); i++)
+                {
+                    optimizer.submitCandidate(candidates[indices[i]], scores[i], seconds[i]);
+                }
+                std::cout << "Bracket " << bracket + 1 << " screened " << batch_amount << " full " << indices.size() << " best " << optimizer.getBestScore()
+                    << (optimizer.getBestScore() > best_before ? " improved" : "") << " spent " << getSpentUnits() << " units" << std::endl;
+                break;
+            }
+
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                optimizer.archiveScreening(candidates[indices[i]], scores[i], (int)rungs.size() - 1 - r, seconds[i]);
+            }
+
+            // Rank on this rung, ties keep the spawn order
+            std::vector<int> order(indices.size());
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                order[i] = (int)i;
+            }
+            std::stable_sort(order.begin(), order.end(), [&scores](int a, int b)
+            {
+                return scores[a] > scores[b];
+            });
+
+            int keep_amount = std::max((int)std::ceil(indices.size() * keep_fraction), 1);
+            std::vector<int> kept;
+            for (int k = 0; k < keep_amount && k < (int)order.size(); k++)
+            {
+                kept.push_back(indices[order[k]]);
+            }
+            indices = kept;
+        }
+
+        bracket++;
+    }
+}
+
+double MultiFidelityScheduler::getSpentUnits()
+{
+    // Until the top rung ran, the highest measured rung estimates the seconds of one unit
+    for (int r = (int)rungs.size() - 1; r >= 0; r--)
+    {
+        if (rungs[r].seconds_per_evaluation > 0.0)
+        {
+            return spent_seconds / (rungs[r].seconds_per_evaluation / rungCost(r));
+        }
+    }
+    return 0.0;
+}
+
+long long MultiFidelityScheduler::getScreenedAmount()
+{
+    return screened_amount;
+}
+
+const std::vector<FidelityRung>& MultiFidelityScheduler::getRungs()
+{
+    return rungs;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "libs/glm/glm.hpp"
+
+#include "optimizer.h"
+#include "cpu_rasterizer.h"
+#include "fitness_cache.h"
+
+// One fidelity level, every rung below the top halves the frame size and the frame count
+struct FidelityRung
+{
+    int frame_width;
+    int frame_height;
+    int frame_amount;
+
+    // Measured evaluator seconds per candidate, 0 until the rung ran once
+    double seconds_per_evaluation;
+    long long evaluations;
+};
+
+// Successive halving over resolution and frame count. Each bracket spawns a large
+// batch of candidates, scores them at the lowest fidelity, keeps the best
+// keep_fraction, re-scores those at the next fidelity and so on. Only candidates
+// that reach the top rung are scored at full fidelity and submitted to the
+// optimizer. Budgets are in cost units, one unit is the measured evaluator time
+// of one full fidelity evaluation, so the bracket size follows the real costs.
+class MultiFidelityScheduler
+{
+    private:
+    Optimizer& optimizer;
+    FitnessCache* fitness_cache;
+
+    int worker_amount;
+    int time_resolution;
+    glm::vec3 anchor;
+    double keep_fraction;
+
+    std::vector<FidelityRung> rungs;
+    double spent_seconds;
+    long long screened_amount;
+
+    // Cost of one evaluation on a rung in full fidelity units
+    double rungCost(int rung);
+    // Fills the evaluator seconds of every candidate, 0 for cached ones
+    std::vector<int> evaluateRung(int rung, const std::vector<Individual>& candidates, const std::vector<int>& indices, std::vector<double>& seconds);
+
+    protected:
+    public:
+    MultiFidelityScheduler(Optimizer& optimizer, FitnessCache* fitness_cache, int worker_amount, int frame_width, int frame_height, int time_resolution, glm::vec3 anchor, int rung_amount, double keep_fraction);
+    // Runs brackets of about bracket_units until budget_units are spent
+    void run(double budget_units, double bracket_units);
+    double getSpentUnits();
+    long long getScreenedAmount();
+    const std::vector<FidelityRung>& getRungs();
+};
+
+// Every stride'th sample and always the last one, so the motion still ends in its final pose
+template <typename T>
+std::vector<T> subsampleSequence(const std::vector<T>& sequence, int frame_amount)
+{
+    if (frame_amount >= (int)sequence.size() || frame_amount < 2)
+    {
+        return sequence;
+    }
+
+    std::vector<T> result(frame_amount);
+    for (int k = 0; k < frame_amount; k++)
+    {
+        size_t index = (size_t)((double)k * (sequence.size() - 1) / (frame_amount - 1) + 0.5);
+        result[k] = sequence[index];
+    }
+    return result;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+
+#include "libs/glm/glm.hpp"
+
+#include "util.h"
+
+// Parameters of one Gaussian bump mutation, mean and stddev are in samples
+struct GaussianBump
+{
+    double mean;
+    double stddev;
+    double multiplier;
+};
+
+// Nearest float of a mutation parameter, so the candidate archive can store it exactly.
+// The volatile keeps the rounding: GCC 12 at -O2 drops (double)(float) round trips
+// when it vectorizes two of them side by side.
+inline double roundToFloat(double value)
+{
+    volatile float rounded = (float)value;
+    return rounded;
+}
+
+// The mutation operators on plain sample vectors. The optimizer draws their
+// parameters, the candidate archive replays them from stored parameters, so
+// both must go through these functions to produce the same bits.
+
+inline void applyYawBump(std::vector<double>& yaws, const GaussianBump& bump)
+{
+    for (size_t i = 0; i < yaws.size(); i++)
+    {
+        double add = bump.multiplier * normalPDF((double)i, bump.mean, bump.stddev);
+        yaws[i] = yaws[i] + add;
+    }
+}
+
+inline void applyOffsetBumps(std::vector<glm::vec3>& offsets, const GaussianBump& bump_x, const GaussianBump& bump_y)
+{
+    for (size_t i = 0; i < offsets.size(); i++)
+    {
+        double add_x = bump_x.multiplier * normalPDF((double)i, bump_x.mean, bump_x.stddev);
+        double add_y = bump_y.multiplier * normalPDF((double)i, bump_y.mean, bump_y.stddev);
+        offsets[i] = offsets[i] + glm::vec3((float)add_x, (float)add_y, 0.0f);
+    }
+}
+
+// Logistic weight of the second parent, blend_width frames wide around the crossover index
+template <typename T>
+inline std::vector<T> blendSequences(const std::vector<T>& a, const std::vector<T>& b, double crossover, double blend_width)
+{
+    std::vector<T> result(a.size());
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        double weight = 1.0 / (1.0 + exp(-((double)i - crossover) / blend_width));
+        result[i] = a[i] * (float)(1.0 - weight) + b[i] * (float)weight;
+    }
+    return result;
+}
+
+inline std::vector<double> blendSequences(const std::vector<double>& a, const std::vector<double>& b, double crossover, double blend_width)
+{
+    std::vector<double> result(a.size());
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        double weight = 1.0 / (1.0 + exp(-((double)i - crossover) / blend_width));
+        result[i] = a[i] * (1.0 - weight) + b[i] * weight;
+    }
+    return result;
+}
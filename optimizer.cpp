@@ -1,113 +1,1071 @@
 #include "optimizer.h"
+#include "candidate_archive.h"
+#include "trace.h"
+#include "perf_counters.h"
 
-Optimizer::Optimizer(int time_resolution, std::vector<double> root_yaw_sequence, std::vector<glm::vec3> root_offset_sequence, int population_amount, int surviver_amount)
-: time_resolution(time_resolution), root_yaw_sequence(root_yaw_sequence), root_offset_sequence(root_offset_sequence), population_amount(population_amount), surviver_amount(surviver_amount)
+// Bias, recombination flag and five values for every bump channel
+static const int surrogate_feature_amount = 17;
+// While screening, one child in this many is bred without it so the step size sees the plain mutation distribution
+static const int unscreened_share = 5;
+
+Optimizer::Optimizer(int time_resolution, std::vector<double> root_yaw_sequence, std::vector<glm::vec3> root_offset_sequence, int population_amount, int surviver_amount, int basis_size, uint64_t seed)
+: time_resolution(time_resolution), population_amount(population_amount), surviver_amount(std::max(surviver_amount, 1)), basis_size(basis_size), seed(seed), generation(0), selection_mode(SELECTION_PLUS), recombination_rate(0.3), basis(basis_size, time_resolution), surrogate_oversampling(1), surrogate(surrogate_feature_amount, 1.0, 0.995), screened_amount(0), guided_fraction(0.0), spawn_amount(0), next_id(1), archive(nullptr), survivors_changed(true), root_yaw_sequence(root_yaw_sequence), root_offset_sequence(root_offset_sequence)
 {
-    survived_yaw_sequence = root_yaw_sequence;
-    survived_offset_sequence = root_offset_sequence;
+    step_size.amplitude_scale = 1.0;
+    step_size.width_fraction = 1.0;
+    step_size.success_rate = 0.2;
 
-    std::vector<std::vector<double>> init_yaw_sequences(population_amount, std::vector<double>(time_resolution));
-    std::vector<std::vector<glm::vec3>> init_offset_sequences(population_amount, std::vector<glm::vec3>(time_resolution));
+    std::cout << "Constructor of Optimizer" << std::endl;
 
-    yaw_sequences = init_yaw_sequences;
-    offset_sequences = init_offset_sequences;
+    // The first generation is bred by loadPopulation or spawnCandidate, after the setters had their say
+    setSurvivedIndividual(root_yaw_sequence, root_offset_sequence);
 
     std::cout << "Constructor of Optimizer" << std::endl;
+}
 
-    inflatePopulation();
+void Optimizer::setSelectionMode(SelectionMode selection_mode)
+{
+    this->selection_mode = selection_mode;
+}
 
-    std::cout << "Constructor of Optimizer" << std::endl;
+void Optimizer::setRecombinationRate(double recombination_rate)
+{
+    this->recombination_rate = recombination_rate;
+}
+
+void Optimizer::setSurrogateOversampling(int surrogate_oversampling)
+{
+    this->surrogate_oversampling = std::max(surrogate_oversampling, 1);
+}
+
+void Optimizer::setStepSizeRegions(int region_amount)
+{
+    step_size.region_scales.assign(std::max(region_amount, 0), 1.0);
+}
+
+void Optimizer::setAmplitudeScale(double amplitude_scale)
+{
+    step_size.amplitude_scale = amplitude_scale;
+}
+
+void Optimizer::setGuidedProposals(double guided_fraction, int map_width, int map_height, glm::vec3 anchor)
+{
+    this->guided_fraction = std::min(std::max(guided_fraction, 0.0), 1.0);
+    kill_map.reset(new CoverageMap(map_width, map_height, anchor));
+    kill_map_yaw.clear();
+    kill_map_offset.clear();
+    kill_cumulative.clear();
+}
+
+const StepSizeState& Optimizer::getStepSizeState()
+{
+    return step_size;
 }
 
 void Optimizer::inflatePopulation()
 {
-    for (int i = 0; i < population_amount; i++)
+    TraceSpan inflate_span("Optimizer::inflatePopulation");
+
+    // Parents without a score are evaluated once as part of this generation
+    children.clear();
+    std::vector<Individual> evaluated_parents;
+    for (const Individual& parent : parents)
     {
-        if (i == 0)
+        if (parent.evaluated)
+        {
+            evaluated_parents.push_back(parent);
+        }
+        else if ((int)children.size() < population_amount)
         {
-            yaw_sequences[i] = survived_yaw_sequence;
-            offset_sequences[i] = survived_offset_sequence;
+            children.push_back(parent);
         }
-        else
+    }
+    if (evaluated_parents.size() != parents.size())
+    {
+        survivors_changed = true;
+    }
+    parents = evaluated_parents;
+    {
+        TraceSpan span("optimizer/refresh_kill_map");
+        refreshKillMap();
+    }
+
+    std::vector<Individual> pool = parents.empty() ? children : parents;
+    int slot_amount = population_amount - (int)children.size();
+    bool screening = surrogate_oversampling > 1 && surrogate.isReady();
+    // The first children skip screening, breeding draws them no differently from the rest
+    int unscreened_amount = screening ? std::min(slot_amount, std::max(1, slot_amount / unscreened_share)) : slot_amount;
+    int breed_amount = unscreened_amount + (slot_amount - unscreened_amount) * (screening ? surrogate_oversampling : 1);
+
+    std::vector<Individual> offspring;
+    {
+        TraceSpan span("optimizer/breed");
+        PerfScope perf_scope(PERF_PHASE_MUTATION);
+        for (int i = 0; i < breed_amount; i++)
         {
-            yaw_sequences[i] = addNoiseToYaw(survived_yaw_sequence);
-            offset_sequences[i] = addNoiseToOffset(survived_offset_sequence);
+            Individual child = breedChild(pool, (int)children.size() + i);
+            child.unscreened = i < unscreened_amount;
+            if (surrogate.isReady() && child.has_parent_score)
+            {
+                child.predicted_score = child.parent_score + surrogate.predict(surrogateFeatures(child));
+                child.has_prediction = true;
+            }
+            offspring.push_back(child);
         }
     }
+
+    // Only the children with the best predicted scores are rendered
+    if (screening)
+    {
+        TraceSpan span("optimizer/screen");
+        std::stable_sort(offspring.begin() + unscreened_amount, offspring.end(), [](const Individual& a, const Individual& b)
+        {
+            return a.predicted_score > b.predicted_score;
+        });
+        offspring.resize(slot_amount);
+    }
+    screened_amount = breed_amount;
+    children.insert(children.end(), offspring.begin(), offspring.end());
+
+    generation++;
 }
 
-std::vector<double> Optimizer::addNoiseToYaw(std::vector<double> yaws) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+Individual Optimizer::breedChild(const std::vector<Individual>& pool, int index)
+{
+    RngStream selection_stream(seed, generation, index, RNG_PURPOSE_SELECTION);
+    RngStream recombination_stream(seed, generation, index, RNG_PURPOSE_RECOMBINATION);
+    RngStream yaw_stream(seed, generation, index, RNG_PURPOSE_YAW);
+    RngStream offset_stream(seed, generation, index, RNG_PURPOSE_OFFSET);
 
-    double lower_bound = -0.1;
-    double upper_bound = 0.1;
-    std::uniform_real_distribution<double> distribution(lower_bound, upper_bound);
+    int first = selection_stream.nextUInt() % pool.size();
+    Individual child = pool[first];
+    child.recombined = false;
+    child.parent_score = pool[first].score;
+    child.has_parent_score = pool[first].evaluated;
+    child.partner_id = 0;
 
-    lower_bound = 0;
-    upper_bound = time_resolution - 1;
-    std::uniform_real_distribution<double> mean_distribution(lower_bound, upper_bound);
+    if (pool.size() > 1 && selection_stream.nextUniform() < recombination_rate)
+    {
+        int second = (first + 1 + selection_stream.nextUInt() % (pool.size() - 1)) % pool.size();
+        child = recombine(pool[first], pool[second], recombination_stream);
+        child.recombined = true;
+        child.partner_id = pool[second].id;
+        child.parent_score = (pool[first].score + pool[second].score) / 2;
+        child.has_parent_score = pool[first].evaluated && pool[second].evaluated;
+    }
+    child.has_prediction = false;
+    child.predicted_score = 0.0;
+    child.unscreened = true;
+    child.dispatched = false;
+    child.id = next_id++;
+    child.parent_id = pool[first].id;
 
-    lower_bound = 1;
-    upper_bound = time_resolution - 1 / 10.0;
-    std::uniform_real_distribution<double> stddev_distribution(lower_bound, upper_bound);
+    if (basis_size > 0)
+    {
+        // Only the control points are mutated, the samples are evaluated on demand
+        child.motion.yaw_controls = addNoiseToYaw(child.motion.yaw_controls, yaw_stream, child.yaw_bump);
+        child.motion.offset_controls = addNoiseToOffset(child.motion.offset_controls, offset_stream, child.x_bump, child.y_bump);
+        basis.evaluate(child.motion, child.yaw_sequence, child.offset_sequence);
+    }
+    else
+    {
+        child.yaw_sequence = addNoiseToYaw(child.yaw_sequence, yaw_stream, child.yaw_bump);
+        child.offset_sequence = addNoiseToOffset(child.offset_sequence, offset_stream, child.x_bump, child.y_bump);
+    }
+
+    child.score = 0;
+    child.evaluated = false;
+    return child;
+}
 
-    double mean = mean_distribution(gen);
-    double stddev = stddev_distribution(gen);
+Individual Optimizer::recombine(const Individual& a, const Individual& b, RngStream& stream)
+{
+    Individual child = a;
 
-    double multiplier = distribution(gen);
+    int sample_amount = basis_size > 0 ? (int)a.motion.yaw_controls.size() : time_resolution;
 
-    for (size_t i = 0; i < time_resolution; i++) {
-        double add = multiplier * normalPDF((double)i, mean, stddev);
-        yaws[i] = yaws[i];
+    // Crossover at a random index with a smooth blend window, otherwise plain averaging
+    double crossover = sample_amount / 2.0;
+    double blend_width = 1e9;
+    if (stream.nextUniform() < 0.5)
+    {
+        crossover = stream.nextUniform() * (sample_amount - 1);
+        blend_width = 0.5 + stream.nextUniform() * sample_amount / 20.0;
     }
+    // Rounded to float so the candidate archive stores the window exactly
+    child.crossover = roundToFloat(crossover);
+    child.blend_width = roundToFloat(blend_width);
+    crossover = child.crossover;
+    blend_width = child.blend_width;
 
-    return yaws;
+    if (basis_size > 0)
+    {
+        child.motion.yaw_controls = blendSequences(a.motion.yaw_controls, b.motion.yaw_controls, crossover, blend_width);
+        child.motion.offset_controls = blendSequences(a.motion.offset_controls, b.motion.offset_controls, crossover, blend_width);
+    }
+    else
+    {
+        child.yaw_sequence = blendSequences(a.yaw_sequence, b.yaw_sequence, crossover, blend_width);
+        child.offset_sequence = blendSequences(a.offset_sequence, b.offset_sequence, crossover, blend_width);
+    }
+
+    return child;
 }
 
-std::vector<glm::vec3> Optimizer::addNoiseToOffset(std::vector<glm::vec3> offsets)
+GaussianBump Optimizer::drawBump(int sample_amount, double base_amplitude, RngStream& stream)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    // Mean, stddev and multiplier in [0, 1), mapped to their ranges below
+    double draws[3];
+    stream.fillUniform(draws, 3);
 
-    double lower_bound = -0.01;
-    double upper_bound = 0.01;
-    std::uniform_real_distribution<double> distribution(lower_bound, upper_bound);
+    double max_stddev = std::max(1.0, std::min(step_size.width_fraction * sample_amount, sample_amount - 1 / 10.0));
 
-    lower_bound = 0;
-    upper_bound = time_resolution - 1;
-    std::uniform_real_distribution<double> mean_distribution(lower_bound, upper_bound);
+    GaussianBump bump;
+    bump.mean = draws[0] * (sample_amount - 1);
+    bump.stddev = 1 + draws[1] * (max_stddev - 1);
 
-    lower_bound = 1;
-    upper_bound = time_resolution - 1 / 10.0;
-    std::uniform_real_distribution<double> stddev_distribution(lower_bound, upper_bound);
+    if (guided_fraction > 0.0 && !kill_cumulative.empty())
+    {
+        double guide_draws[2];
+        stream.fillUniform(guide_draws, 2);
+        if (guide_draws[0] < guided_fraction)
+        {
+            // Frames are picked in proportion to the pixels only they kill, the width follows their binding run
+            double target = guide_draws[1] * kill_cumulative.back();
+            int frame = (int)(std::upper_bound(kill_cumulative.begin(), kill_cumulative.end(), target) - kill_cumulative.begin());
+            frame = std::min(frame, (int)kill_cumulative.size() - 1);
 
-    double mean_x = mean_distribution(gen);
-    double stddev_x = stddev_distribution(gen);
-    double multiplier_x = distribution(gen);
+            double spread = samplePositionOfFrame(frame + kill_spread[frame]) - samplePositionOfFrame(frame);
+            bump.mean = std::min(std::max(samplePositionOfFrame(frame), 0.0), sample_amount - 1.0);
+            bump.stddev = std::min(std::max(spread * (0.5 + draws[1]), 1.0), max_stddev);
+        }
+    }
 
-    double mean_y = mean_distribution(gen);
-    double stddev_y = stddev_distribution(gen);
-    double multiplier_y = distribution(gen);
+    double amplitude = base_amplitude * step_size.amplitude_scale;
+    if (!step_size.region_scales.empty())
+    {
+        amplitude *= step_size.region_scales[regionOf(bump.mean / sample_amount)];
+    }
+    bump.multiplier = -amplitude + draws[2] * 2.0 * amplitude;
+
+    // Rounded to float so the candidate archive stores the bump exactly
+    bump.mean = roundToFloat(bump.mean);
+    bump.stddev = roundToFloat(bump.stddev);
+    bump.multiplier = roundToFloat(bump.multiplier);
+
+    return bump;
+}
+
+int Optimizer::regionOf(double position)
+{
+    int region_amount = (int)step_size.region_scales.size();
+    return std::min(std::max((int)(position * region_amount), 0), region_amount - 1);
+}
+
+double Optimizer::samplePositionOfFrame(double frame)
+{
+    if (basis_size <= 0 || time_resolution < 2)
+    {
+        return frame;
+    }
+    double segment_amount = basis.getControlAmount() - 3;
+    return frame * segment_amount / (time_resolution - 1) + 1.0;
+}
+
+void Optimizer::refreshKillMap()
+{
+    if (guided_fraction <= 0.0 || !kill_map)
+    {
+        return;
+    }
+
+    const Individual* best = nullptr;
+    for (const Individual& parent : parents)
+    {
+        if (parent.evaluated && (!best || parent.score > best->score))
+        {
+            best = &parent;
+        }
+    }
+    if (!best || (best->yaw_sequence == kill_map_yaw && best->offset_sequence == kill_map_offset))
+    {
+        return;
+    }
+
+    kill_map_yaw = best->yaw_sequence;
+    kill_map_offset = best->offset_sequence;
+    kill_map->build(kill_map_yaw, kill_map_offset);
+    std::vector<int> kills = kill_map->uniqueKills();
+
+    int frame_amount = (int)kills.size();
+    kill_cumulative.assign(frame_amount, 0.0);
+    kill_spread.assign(frame_amount, 1.0);
+    double total = 0.0;
+    for (int i = 0; i < frame_amount; i++)
+    {
+        total += kills[i];
+        kill_cumulative[i] = total;
+    }
+    if (total <= 0.0)
+    {
+        kill_cumulative.clear();
+        return;
+    }
 
-    for (int i = 0; i < time_resolution; i++)
+    // Runs of binding frames, separated by frames without unique kills
+    int run_begin = 0;
+    while (run_begin < frame_amount)
     {
-        double add_x = multiplier_x * normalPDF((double)i, mean_x, stddev_x);
-        double add_y = multiplier_y * normalPDF((double)i, mean_y, stddev_y);
-        offsets[i] = offsets[i] + glm::vec3((float)add_x, (float)add_y, 0.0f);
+        if (kills[run_begin] == 0)
+        {
+            run_begin++;
+            continue;
+        }
+        int run_end = run_begin;
+        double weight = 0.0;
+        double mean = 0.0;
+        while (run_end < frame_amount && kills[run_end] > 0)
+        {
+            weight += kills[run_end];
+            mean += kills[run_end] * (double)run_end;
+            run_end++;
+        }
+        mean /= weight;
+        double variance = 0.0;
+        for (int i = run_begin; i < run_end; i++)
+        {
+            variance += kills[i] * (i - mean) * (i - mean);
+        }
+        double spread = std::max(sqrt(variance / weight), 1.0);
+        for (int i = run_begin; i < run_end; i++)
+        {
+            kill_spread[i] = spread;
+        }
+        run_begin = run_end;
     }
+}
+
+std::vector<double> Optimizer::addNoiseToYaw(std::vector<double> yaws, RngStream& stream, GaussianBump& bump) {
+    int sample_amount = (int)yaws.size();
+
+    bump = drawBump(sample_amount, 0.1, stream);
+    applyYawBump(yaws, bump);
+
+    return yaws;
+}
+
+std::vector<glm::vec3> Optimizer::addNoiseToOffset(std::vector<glm::vec3> offsets, RngStream& stream, GaussianBump& bump_x, GaussianBump& bump_y)
+{
+    int sample_amount = (int)offsets.size();
+
+    bump_x = drawBump(sample_amount, 0.01, stream);
+    bump_y = drawBump(sample_amount, 0.01, stream);
+    applyOffsetBumps(offsets, bump_x, bump_y);
 
     return offsets;
 }
 
+void Optimizer::adaptStepSize()
+{
+    double sample_amount = basis_size > 0 ? (double)basis.getControlAmount() : (double)time_resolution;
+
+    int trials = 0;
+    int successes = 0;
+    double successful_width = 0.0;
+    // Screened children are the surrogate's picks, their success says more about it than about the step size
+    for (const Individual& child : children)
+    {
+        if (!child.has_parent_score || !child.unscreened)
+        {
+            continue;
+        }
+
+        bool success = child.score > child.parent_score;
+        trials++;
+        if (success)
+        {
+            successes++;
+            successful_width += (child.yaw_bump.stddev + child.x_bump.stddev + child.y_bump.stddev) / (3.0 * sample_amount);
+        }
+
+        // Regions around successful bump centers get larger steps, the others slowly shrink
+        if (!step_size.region_scales.empty())
+        {
+            const GaussianBump* bumps[3] = { &child.yaw_bump, &child.x_bump, &child.y_bump };
+            for (int c = 0; c < 3; c++)
+            {
+                step_size.region_scales[regionOf(bumps[c]->mean / sample_amount)] *= success ? 1.1 : 0.98;
+            }
+        }
+    }
+
+    if (trials == 0)
+    {
+        return;
+    }
+
+    // 1/5 success rule on the smoothed success rate
+    step_size.success_rate = 0.8 * step_size.success_rate + 0.2 * (double)successes / trials;
+    step_size.amplitude_scale *= exp(0.6 * (step_size.success_rate - 0.2));
+    step_size.amplitude_scale = std::min(std::max(step_size.amplitude_scale, 1e-3), 1e2);
+
+    // Follow the widths that produced improvements
+    if (successes > 0)
+    {
+        double target = std::min(1.0, 2.0 * successful_width / successes);
+        step_size.width_fraction = 0.9 * step_size.width_fraction + 0.1 * target;
+        step_size.width_fraction = std::max(step_size.width_fraction, 2.0 / sample_amount);
+    }
+
+    if (!step_size.region_scales.empty())
+    {
+        double mean_scale = 0.0;
+        for (double scale : step_size.region_scales)
+        {
+            mean_scale += scale / step_size.region_scales.size();
+        }
+        for (double& scale : step_size.region_scales)
+        {
+            scale = std::min(std::max(scale / mean_scale, 0.1), 10.0);
+        }
+    }
+}
+
+std::vector<double> Optimizer::surrogateFeatures(const Individual& individual)
+{
+    double sample_amount = basis_size > 0 ? (double)basis.getControlAmount() : (double)time_resolution;
+    const GaussianBump* bumps[3] = { &individual.yaw_bump, &individual.x_bump, &individual.y_bump };
+    const double multiplier_ranges[3] = { 0.1, 0.01, 0.01 };
+
+    std::vector<double> features;
+    features.push_back(1.0);
+    features.push_back(individual.recombined ? 1.0 : 0.0);
+    for (int c = 0; c < 3; c++)
+    {
+        double multiplier = bumps[c]->multiplier / multiplier_ranges[c];
+        features.push_back(bumps[c]->mean / sample_amount);
+        features.push_back(bumps[c]->stddev / sample_amount);
+        features.push_back(multiplier);
+        features.push_back(std::fabs(multiplier));
+        // Peak height of the bump relative to its widest possible version
+        features.push_back(multiplier * sample_amount / bumps[c]->stddev / 100.0);
+    }
+    return features;
+}
+
 void Optimizer::loadPopulation(std::vector<std::vector<double>>& yaws, std::vector<std::vector<glm::vec3>>& offsets)
 {
-    yaws = yaw_sequences;
-    offsets = offset_sequences;
+    TraceSpan span("Optimizer::loadPopulation");
+    if (generation == 0)
+    {
+        inflatePopulation();
+    }
+    yaws.resize(children.size());
+    offsets.resize(children.size());
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        yaws[i] = children[i].yaw_sequence;
+        offsets[i] = children[i].offset_sequence;
+    }
+}
+
+void Optimizer::setPopulationScores(const std::vector<int>& scores, const std::vector<double>& seconds)
+{
+    TraceSpan scores_span("Optimizer::setPopulationScores");
+
+    for (size_t i = 0; i < children.size() && i < scores.size(); i++)
+    {
+        children[i].score = scores[i];
+        children[i].evaluated = true;
+        if (archive)
+        {
+            archive->record(children[i], generation, 0, i < seconds.size() ? seconds[i] : 0.0);
+        }
+    }
+
+    {
+        TraceSpan span("optimizer/learn_from_children");
+        learnFromChildren();
+    }
+
+    TraceSpan span("optimizer/select");
+    PerfScope perf_scope(PERF_PHASE_SELECT);
+    // Children come first so that ties favor the new candidates
+    std::vector<Individual> candidates = children;
+    if (selection_mode == SELECTION_PLUS)
+    {
+        candidates.insert(candidates.end(), parents.begin(), parents.end());
+    }
+    std::vector<int> order(candidates.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = (int)i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&candidates](int a, int b)
+    {
+        return candidates[a].score > candidates[b].score;
+    });
+
+    if ((int)order.size() > surviver_amount)
+    {
+        order.resize(surviver_amount);
+    }
+    parents.clear();
+    for (int index : order)
+    {
+        parents.push_back(candidates[index]);
+        if (index < (int)children.size())
+        {
+            survivors_changed = true;
+        }
+    }
+    children.clear();
+}
+
+Individual Optimizer::spawnCandidate()
+{
+    TraceSpan span("Optimizer::spawnCandidate");
+    if (generation == 0)
+    {
+        inflatePopulation();
+    }
+
+    // The first generation from inflatePopulation waits in children, it joins the parents to be handed out
+    for (const Individual& child : children)
+    {
+        if (!child.evaluated)
+        {
+            parents.push_back(child);
+            survivors_changed = true;
+        }
+    }
+    children.erase(std::remove_if(children.begin(), children.end(), [](const Individual& child)
+    {
+        return !child.evaluated;
+    }), children.end());
+
+    // Parents without a score are handed out once before any breeding
+    for (Individual& parent : parents)
+    {
+        if (!parent.evaluated && !parent.dispatched)
+        {
+            parent.dispatched = true;
+            survivors_changed = true;
+            return parent;
+        }
+    }
+
+    refreshKillMap();
+
+    bool screening = surrogate_oversampling > 1 && surrogate.isReady();
+    int slot = spawn_amount % population_amount;
+    int stride = screening ? surrogate_oversampling : 1;
+    bool unscreened = !screening || spawn_amount % unscreened_share == 0;
+    int breed_amount = unscreened ? 1 : surrogate_oversampling;
+
+    PerfScope perf_scope(PERF_PHASE_MUTATION);
+    Individual best;
+    for (int k = 0; k < breed_amount; k++)
+    {
+        Individual child = breedChild(parents, slot * stride + k);
+        child.unscreened = unscreened;
+        if (surrogate.isReady() && child.has_parent_score)
+        {
+            child.predicted_score = child.parent_score + surrogate.predict(surrogateFeatures(child));
+            child.has_prediction = true;
+        }
+        if (k == 0 || child.predicted_score > best.predicted_score)
+        {
+            best = child;
+        }
+    }
+    screened_amount += breed_amount;
+
+    spawn_amount++;
+    if (spawn_amount % population_amount == 0)
+    {
+        generation++;
+    }
+
+    return best;
+}
+
+bool Optimizer::submitCandidate(Individual candidate, int score, double seconds)
+{
+    TraceSpan span("Optimizer::submitCandidate");
+    candidate.score = score;
+    candidate.evaluated = true;
+    if (archive)
+    {
+        archive->record(candidate, generation, 0, seconds);
+    }
+
+    bool improved = true;
+    for (const Individual& parent : parents)
+    {
+        if (parent.evaluated && parent.score >= score)
+        {
+            improved = false;
+        }
+    }
+
+    // A handed out parent without a score only seeded breeding until real scores arrive
+    parents.erase(std::remove_if(parents.begin(), parents.end(), [](const Individual& parent)
+    {
+        return !parent.evaluated && parent.dispatched;
+    }), parents.end());
+
+    PerfScope perf_scope(PERF_PHASE_SELECT);
+    // Inserted first so that ties favor the new candidate
+    parents.insert(parents.begin(), candidate);
+    std::stable_sort(parents.begin(), parents.end(), [](const Individual& a, const Individual& b)
+    {
+        return a.score > b.score;
+    });
+    if ((int)parents.size() > surviver_amount)
+    {
+        parents.resize(surviver_amount);
+    }
+    survivors_changed = true;
+
+    // Surrogate and step sizes learn from batches of population_amount results
+    children.push_back(candidate);
+    if ((int)children.size() >= population_amount)
+    {
+        learnFromChildren();
+        children.clear();
+    }
+
+    return improved;
+}
+
+void Optimizer::learnFromChildren()
+{
+    // Judge the predictions made at breeding time, then learn from the new scores
+    SurrogateStats stats = { generation, screened_amount, (int)children.size(), 0.0, 0.0 };
+    std::vector<double> predicted;
+    std::vector<double> actual;
+    for (const Individual& child : children)
+    {
+        if (child.has_prediction)
+        {
+            predicted.push_back(child.predicted_score);
+            actual.push_back(child.score);
+        }
+    }
+    if (predicted.size() > 1)
+    {
+        double n = (double)predicted.size();
+        double mean_predicted = 0.0;
+        double mean_actual = 0.0;
+        for (size_t i = 0; i < predicted.size(); i++)
+        {
+            mean_predicted += predicted[i] / n;
+            mean_actual += actual[i] / n;
+            stats.mean_absolute_error += std::fabs(predicted[i] - actual[i]) / n;
+        }
+        double covariance = 0.0;
+        double variance_predicted = 0.0;
+        double variance_actual = 0.0;
+        for (size_t i = 0; i < predicted.size(); i++)
+        {
+            covariance += (predicted[i] - mean_predicted) * (actual[i] - mean_actual);
+            variance_predicted += (predicted[i] - mean_predicted) * (predicted[i] - mean_predicted);
+            variance_actual += (actual[i] - mean_actual) * (actual[i] - mean_actual);
+        }
+        if (variance_predicted > 0.0 && variance_actual > 0.0)
+        {
+            stats.correlation = covariance / sqrt(variance_predicted * variance_actual);
+        }
+    }
+    surrogate_stats.push_back(stats);
+
+    for (const Individual& child : children)
+    {
+        if (child.has_parent_score)
+        {
+            surrogate.train(surrogateFeatures(child), (double)(child.score - child.parent_score));
+        }
+    }
+
+    adaptStepSize();
+    screened_amount = 0;
+}
+
+void Optimizer::setArchive(CandidateArchive* archive)
+{
+    this->archive = archive;
+    if (!archive || next_id >= archive->getNextId())
+    {
+        return;
+    }
+
+    // The archive outlives the run, so the ids handed out so far move past the ones earlier runs left in it
+    uint64_t shift = archive->getNextId() - 1;
+    for (std::vector<Individual>* individuals : { &parents, &children })
+    {
+        for (Individual& individual : *individuals)
+        {
+            individual.id += individual.id != 0 ? shift : 0;
+            individual.parent_id += individual.parent_id != 0 ? shift : 0;
+            individual.partner_id += individual.partner_id != 0 ? shift : 0;
+        }
+    }
+    next_id += shift;
+}
+
+void Optimizer::archiveScreening(const Individual& candidate, int score, int fidelity, double seconds)
+{
+    if (archive)
+    {
+        Individual screened = candidate;
+        screened.score = score;
+        archive->record(screened, generation, fidelity, seconds);
+    }
 }
 
 void Optimizer::setSurvivedIndividual(std::vector<double> yaws, std::vector<glm::vec3> offsets)
 {
-    survived_yaw_sequence = yaws;
-    survived_offset_sequence = offsets;
-}
\ No newline at end of file
+    parents.clear();
+    parents.push_back(createIndividual(yaws, offsets));
+    survivors_changed = true;
+}
+
+Individual Optimizer::createIndividual(std::vector<double> yaws, std::vector<glm::vec3> offsets)
+{
+    Individual individual;
+    individual.yaw_sequence = yaws;
+    individual.offset_sequence = offsets;
+    individual.score = 0;
+    individual.evaluated = false;
+    individual.yaw_bump = { 0.0, 1.0, 0.0 };
+    individual.x_bump = { 0.0, 1.0, 0.0 };
+    individual.y_bump = { 0.0, 1.0, 0.0 };
+    individual.recombined = false;
+    individual.parent_score = 0;
+    individual.has_parent_score = false;
+    individual.has_prediction = false;
+    individual.predicted_score = 0.0;
+    individual.unscreened = true;
+    individual.dispatched = false;
+    individual.id = next_id++;
+    individual.parent_id = 0;
+    individual.partner_id = 0;
+    individual.crossover = 0.0;
+    individual.blend_width = 0.0;
+
+    if (basis_size > 0)
+    {
+        individual.motion = basis.fit(yaws, offsets);
+        basis.evaluate(individual.motion, individual.yaw_sequence, individual.offset_sequence);
+    }
+
+    return individual;
+}
+
+Individual Optimizer::mutateIndividual(const Individual& parent, int index)
+{
+    // A pool of one never recombines
+    return breedChild(std::vector<Individual>(1, parent), index);
+}
+
+int Optimizer::getBestScore()
+{
+    return parents.empty() ? 0 : parents[0].score;
+}
+
+std::vector<double> Optimizer::getBestYawSequence()
+{
+    return parents.empty() ? std::vector<double>() : parents[0].yaw_sequence;
+}
+
+std::vector<glm::vec3> Optimizer::getBestOffsetSequence()
+{
+    return parents.empty() ? std::vector<glm::vec3>() : parents[0].offset_sequence;
+}
+
+const std::vector<SurrogateStats>& Optimizer::getSurrogateStats()
+{
+    return surrogate_stats;
+}
+
+void Optimizer::saveStepSizeToFile(const std::string& filename)
+{
+    std::ofstream outfile(filename, std::ios::binary);
+
+    if (outfile.is_open()) {
+        outfile.write(reinterpret_cast<const char*>(&step_size.amplitude_scale), sizeof(double));
+        outfile.write(reinterpret_cast<const char*>(&step_size.width_fraction), sizeof(double));
+        outfile.write(reinterpret_cast<const char*>(&step_size.success_rate), sizeof(double));
+
+        size_t size = step_size.region_scales.size();
+        outfile.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        outfile.write(reinterpret_cast<const char*>(step_size.region_scales.data()), size * sizeof(double));
+
+        outfile.close();
+        std::cout << "Step size saved to file successfully." << std::endl;
+    } else {
+        std::cerr << "Unable to open file for writing." << std::endl;
+    }
+}
+
+bool Optimizer::loadStepSizeFromFile(const std::string& filename)
+{
+    std::ifstream infile(filename, std::ios::binary);
+
+    if (!infile.is_open()) {
+        return false;
+    }
+
+    StepSizeState state;
+    size_t size = 0;
+    infile.read(reinterpret_cast<char*>(&state.amplitude_scale), sizeof(double));
+    infile.read(reinterpret_cast<char*>(&state.width_fraction), sizeof(double));
+    infile.read(reinterpret_cast<char*>(&state.success_rate), sizeof(double));
+    infile.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!infile || size > 1 << 16) {
+        std::cerr << "Step size file is damaged: " << filename << std::endl;
+        return false;
+    }
+    state.region_scales.resize(size);
+    infile.read(reinterpret_cast<char*>(state.region_scales.data()), size * sizeof(double));
+    if (!infile) {
+        std::cerr << "Step size file is damaged: " << filename << std::endl;
+        return false;
+    }
+
+    step_size = state;
+    std::cout << "Step size loaded from file successfully." << std::endl;
+    return true;
+}
+
+static void writeBump(ByteWriter& writer, const GaussianBump& bump)
+{
+    writer.write(bump.mean);
+    writer.write(bump.stddev);
+    writer.write(bump.multiplier);
+}
+
+static void readBump(ByteReader& reader, GaussianBump& bump)
+{
+    reader.read(bump.mean);
+    reader.read(bump.stddev);
+    reader.read(bump.multiplier);
+}
+
+static void writeIndividual(ByteWriter& writer, const Individual& individual)
+{
+    writer.writeVector(individual.yaw_sequence);
+    writer.writeVector(individual.offset_sequence);
+    writer.writeVector(individual.motion.yaw_controls);
+    writer.writeVector(individual.motion.offset_controls);
+    writer.write<int32_t>(individual.score);
+    writer.write<uint8_t>(individual.evaluated);
+    writeBump(writer, individual.yaw_bump);
+    writeBump(writer, individual.x_bump);
+    writeBump(writer, individual.y_bump);
+    writer.write<uint8_t>(individual.recombined);
+    writer.write<int32_t>(individual.parent_score);
+    writer.write<uint8_t>(individual.has_parent_score);
+    writer.write<uint8_t>(individual.has_prediction);
+    writer.write(individual.predicted_score);
+    writer.write<uint8_t>(individual.unscreened);
+    writer.write<uint8_t>(individual.dispatched);
+    writer.write(individual.id);
+    writer.write(individual.parent_id);
+    writer.write(individual.partner_id);
+    writer.write(individual.crossover);
+    writer.write(individual.blend_width);
+}
+
+static bool readIndividual(ByteReader& reader, Individual& individual, int time_resolution)
+{
+    int32_t score = 0;
+    int32_t parent_score = 0;
+    uint8_t evaluated = 0;
+    uint8_t recombined = 0;
+    uint8_t has_parent_score = 0;
+    uint8_t has_prediction = 0;
+    uint8_t unscreened = 0;
+    uint8_t dispatched = 0;
+
+    reader.readVector(individual.yaw_sequence, time_resolution);
+    reader.readVector(individual.offset_sequence, time_resolution);
+    reader.readVector(individual.motion.yaw_controls, time_resolution);
+    reader.readVector(individual.motion.offset_controls, time_resolution);
+    reader.read(score);
+    reader.read(evaluated);
+    readBump(reader, individual.yaw_bump);
+    readBump(reader, individual.x_bump);
+    readBump(reader, individual.y_bump);
+    reader.read(recombined);
+    reader.read(parent_score);
+    reader.read(has_parent_score);
+    reader.read(has_prediction);
+    reader.read(individual.predicted_score);
+    reader.read(unscreened);
+    reader.read(dispatched);
+    reader.read(individual.id);
+    reader.read(individual.parent_id);
+    reader.read(individual.partner_id);
+    reader.read(individual.crossover);
+    reader.read(individual.blend_width);
+
+    individual.score = score;
+    individual.evaluated = evaluated != 0;
+    individual.recombined = recombined != 0;
+    individual.parent_score = parent_score;
+    individual.has_parent_score = has_parent_score != 0;
+    individual.has_prediction = has_prediction != 0;
+    individual.unscreened = unscreened != 0;
+    individual.dispatched = dispatched != 0;
+
+    return !reader.hasFailed() && (int)individual.yaw_sequence.size() == time_resolution && (int)individual.offset_sequence.size() == time_resolution;
+}
+
+void Optimizer::saveState(ByteWriter& writer, bool full)
+{
+    TraceSpan span("Optimizer::saveState");
+    writer.write<int32_t>(time_resolution);
+    writer.write<int32_t>(basis_size);
+    writer.write<uint64_t>(seed);
+    writer.write<int32_t>(generation);
+    writer.write<int32_t>(spawn_amount);
+    writer.write<uint64_t>(next_id);
+    writer.write<int32_t>(screened_amount);
+
+    writer.write(step_size.amplitude_scale);
+    writer.write(step_size.width_fraction);
+    writer.write(step_size.success_rate);
+    writer.writeVector(step_size.region_scales);
+
+    surrogate.saveState(writer);
+
+    // Statistics are appended from this index on
+    size_t stats_begin = full || surrogate_stats.empty() ? 0 : surrogate_stats.size() - 1;
+    writer.write<uint64_t>(stats_begin);
+    writer.write<uint64_t>(surrogate_stats.size() - stats_begin);
+    for (size_t i = stats_begin; i < surrogate_stats.size(); i++)
+    {
+        writer.write(surrogate_stats[i]);
+    }
+
+    bool write_survivors = full || survivors_changed;
+    writer.write<uint8_t>(write_survivors);
+    if (write_survivors)
+    {
+        writer.write<uint32_t>(parents.size());
+        for (const Individual& parent : parents)
+        {
+            writeIndividual(writer, parent);
+        }
+        writer.write<uint32_t>(children.size());
+        for (const Individual& child : children)
+        {
+            writeIndividual(writer, child);
+        }
+    }
+    survivors_changed = false;
+}
+
+bool Optimizer::loadState(ByteReader& reader)
+{
+    int32_t saved_time_resolution = 0;
+    int32_t saved_basis_size = 0;
+    uint64_t saved_seed = 0;
+    reader.read(saved_time_resolution);
+    reader.read(saved_basis_size);
+    reader.read(saved_seed);
+    if (reader.hasFailed() || saved_time_resolution != time_resolution || saved_basis_size != basis_size || saved_seed != seed)
+    {
+        std::cerr << "Optimizer state was saved with a different time resolution, basis size or seed" << std::endl;
+        return false;
+    }
+
+    int32_t saved_generation = 0;
+    int32_t saved_spawn_amount = 0;
+    int32_t saved_screened_amount = 0;
+    reader.read(saved_generation);
+    reader.read(saved_spawn_amount);
+    uint64_t saved_next_id = 1;
+    reader.read(saved_next_id);
+    reader.read(saved_screened_amount);
+
+    StepSizeState saved_step_size;
+    reader.read(saved_step_size.amplitude_scale);
+    reader.read(saved_step_size.width_fraction);
+    reader.read(saved_step_size.success_rate);
+    reader.readVector(saved_step_size.region_scales, 1 << 16);
+
+    Surrogate saved_surrogate = surrogate;
+    if (reader.hasFailed() || !saved_surrogate.loadState(reader))
+    {
+        std::cerr << "Optimizer state is damaged" << std::endl;
+        return false;
+    }
+
+    uint64_t stats_begin = 0;
+    uint64_t stats_amount = 0;
+    reader.read(stats_begin);
+    reader.read(stats_amount);
+    if (reader.hasFailed() || stats_begin > surrogate_stats.size() || stats_amount > reader.getRemaining() / sizeof(SurrogateStats))
+    {
+        std::cerr << "Optimizer state is damaged" << std::endl;
+        return false;
+    }
+    std::vector<SurrogateStats> saved_stats(surrogate_stats.begin(), surrogate_stats.begin() + stats_begin);
+    for (uint64_t i = 0; i < stats_amount; i++)
+    {
+        SurrogateStats stats;
+        reader.read(stats);
+        saved_stats.push_back(stats);
+    }
+
+    uint8_t has_survivors = 0;
+    reader.read(has_survivors);
+    std::vector<Individual> saved_parents = parents;
+    std::vector<Individual> saved_children = children;
+    if (has_survivors)
+    {
+        uint32_t parent_amount = 0;
+        reader.read(parent_amount);
+        saved_parents.assign(std::min<uint32_t>(parent_amount, 1 << 16), Individual());
+        for (Individual& parent : saved_parents)
+        {
+            if (!readIndividual(reader, parent, time_resolution))
+            {
+                std::cerr << "Optimizer state holds a population of another time resolution or is damaged" << std::endl;
+                return false;
+            }
+        }
+        uint32_t child_amount = 0;
+        reader.read(child_amount);
+        saved_children.assign(std::min<uint32_t>(child_amount, 1 << 16), Individual());
+        for (Individual& child : saved_children)
+        {
+            if (!readIndividual(reader, child, time_resolution))
+            {
+                std::cerr << "Optimizer state holds a population of another time resolution or is damaged" << std::endl;
+                return false;
+            }
+        }
+    }
+    if (reader.hasFailed())
+    {
+        std::cerr << "Optimizer state is damaged" << std::endl;
+        return false;
+    }
+
+    generation = saved_generation;
+    spawn_amount = saved_spawn_amount;
+    // Another run may have appended to the archive since the state was saved
+    next_id = archive ? std::max(saved_next_id, archive->getNextId()) : saved_next_id;
+    screened_amount = saved_screened_amount;
+    step_size = saved_step_size;
+    surrogate = saved_surrogate;
+    surrogate_stats = saved_stats;
+    parents = saved_parents;
+    children = saved_children;
+    survivors_changed = false;
+    return true;
+}
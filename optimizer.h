@@ -2,11 +2,75 @@
 
 #include <iostream>
 #include <vector>
-#include <random>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
 
 #include "libs/glm/glm.hpp"
 
 #include "util.h"
+#include "spline_basis.h"
+#include "rng.h"
+#include "surrogate.h"
+#include "serialize.h"
+#include "coverage_map.h"
+#include "mutation.h"
+
+// (mu + lambda) keeps the best parents and children, (mu, lambda) only the best children
+enum SelectionMode
+{
+    SELECTION_PLUS = 0,
+    SELECTION_COMMA = 1
+};
+
+// Self-adapted mutation strength, logged every generation and saved with the motion
+struct StepSizeState
+{
+    // Multiplies the base bump amplitudes of yaw (0.1) and offsets (0.01)
+    double amplitude_scale;
+    // Widest bump stddev as a fraction of the mutated samples
+    double width_fraction;
+    // Smoothed fraction of children that beat their parent, the 1/5 rule steers it towards 0.2
+    double success_rate;
+    // Amplitude multipliers of equally sized time regions, learned from where successful bumps were centered
+    std::vector<double> region_scales;
+};
+
+struct Individual
+{
+    std::vector<double> yaw_sequence;
+    std::vector<glm::vec3> offset_sequence;
+    // Control points the sequences are evaluated from when a spline basis is used
+    SplineMotion motion;
+
+    int score;
+    bool evaluated;
+
+    // How the individual was made, used as surrogate features
+    GaussianBump yaw_bump;
+    GaussianBump x_bump;
+    GaussianBump y_bump;
+    bool recombined;
+    int parent_score;
+    bool has_parent_score;
+    bool has_prediction;
+    double predicted_score;
+    // Bred without surrogate screening, only these children steer the step size
+    bool unscreened;
+
+    // Handed out by spawnCandidate while its score is still unknown
+    bool dispatched;
+
+    // Lineage for the candidate archive, ids count up past the archive's largest and 0 means none
+    uint64_t id;
+    uint64_t parent_id;
+    uint64_t partner_id;
+    // Recombination window, only used if partner_id is set
+    double crossover;
+    double blend_width;
+};
+
+class CandidateArchive;
 
 class Optimizer
 {
@@ -14,23 +78,108 @@ class Optimizer
     int time_resolution;
     int population_amount;
     int surviver_amount;
+    // Number of spline control points per channel, 0 mutates the raw per-frame samples
+    int basis_size;
+
+    // Every mutation draws from its own stream keyed by (seed, generation, individual, purpose)
+    uint64_t seed;
+    int generation;
+
+    SelectionMode selection_mode;
+    // Probability that a child is recombined from two parents before it is mutated
+    double recombination_rate;
+
+    SplineBasis basis;
+
+    // Children bred per slot before the surrogate keeps the most promising ones, 1 disables screening
+    int surrogate_oversampling;
+    Surrogate surrogate;
+    std::vector<SurrogateStats> surrogate_stats;
+    int screened_amount;
+
+    StepSizeState step_size;
+
+    // Share of bumps centered on frames that bind the best survivor, 0 keeps every bump uniform
+    double guided_fraction;
+    std::unique_ptr<CoverageMap> kill_map;
+    // Cumulative unique kills over the frames and the kill weighted spread, in frames, of the binding run each frame belongs to
+    std::vector<double> kill_cumulative;
+    std::vector<double> kill_spread;
+    // Motion the kill map was built from
+    std::vector<double> kill_map_yaw;
+    std::vector<glm::vec3> kill_map_offset;
+
+    // Candidates handed out in steady-state mode
+    int spawn_amount;
+    // Id of the next individual that is created or bred
+    uint64_t next_id;
+
+    // Every scored candidate is appended here if set
+    CandidateArchive* archive;
+
+    // Set whenever the parents change, cleared by saveState so the journal only carries new survivors
+    bool survivors_changed;
 
     std::vector<double> root_yaw_sequence;
     std::vector<glm::vec3> root_offset_sequence;
 
-    std::vector<double> survived_yaw_sequence;
-    std::vector<glm::vec3> survived_offset_sequence;
+    // The surviver_amount best individuals, their scores are kept so they are never rendered twice
+    std::vector<Individual> parents;
+    // Candidates of the current generation that wait for their scores
+    std::vector<Individual> children;
 
-    std::vector<std::vector<double>> yaw_sequences;
-    std::vector<std::vector<glm::vec3>> offset_sequences;
+    Individual breedChild(const std::vector<Individual>& pool, int index);
+    Individual recombine(const Individual& a, const Individual& b, RngStream& stream);
+    std::vector<double> surrogateFeatures(const Individual& individual);
+    GaussianBump drawBump(int sample_amount, double base_amplitude, RngStream& stream);
+    int regionOf(double position);
+    void refreshKillMap();
+    // Position of a frame among the mutated samples, control points peak one segment after their index
+    double samplePositionOfFrame(double frame);
+    void adaptStepSize();
+    void learnFromChildren();
 
     protected:
 
     public:
-    Optimizer(int time_resolution, std::vector<double> root_yaw_sequence, std::vector<glm::vec3> root_offset_sequence, int population_amount, int surviver_amount);
+    Optimizer(int time_resolution, std::vector<double> root_yaw_sequence, std::vector<glm::vec3> root_offset_sequence, int population_amount, int surviver_amount, int basis_size, uint64_t seed);
+    void setSelectionMode(SelectionMode selection_mode);
+    void setRecombinationRate(double recombination_rate);
+    void setSurrogateOversampling(int surrogate_oversampling);
+    void setStepSizeRegions(int region_amount);
+    // Starting value of the self-adapted amplitude scale
+    void setAmplitudeScale(double amplitude_scale);
+    // Centers guided_fraction of the bumps on binding frames of the best survivor, found in a kill map of the given size
+    void setGuidedProposals(double guided_fraction, int map_width, int map_height, glm::vec3 anchor);
+    const StepSizeState& getStepSizeState();
+    void saveStepSizeToFile(const std::string& filename);
+    bool loadStepSizeFromFile(const std::string& filename);
     void inflatePopulation();
-    std::vector<double> addNoiseToYaw(std::vector<double> yaws);
-    std::vector<glm::vec3> addNoiseToOffset(std::vector<glm::vec3> offsets);
+    std::vector<double> addNoiseToYaw(std::vector<double> yaws, RngStream& stream, GaussianBump& bump);
+    std::vector<glm::vec3> addNoiseToOffset(std::vector<glm::vec3> offsets, RngStream& stream, GaussianBump& bump_x, GaussianBump& bump_y);
+    // Breeds the first generation on the first call
     void loadPopulation(std::vector<std::vector<double>>& yaws, std::vector<std::vector<glm::vec3>>& offsets);
+    // Evaluator seconds per child are only used for the archive
+    void setPopulationScores(const std::vector<int>& scores, const std::vector<double>& seconds = std::vector<double>());
+    // Steady-state mode without generation barriers, always (mu + 1) selection
+    Individual spawnCandidate();
+    // Returns true if the candidate became the new best individual
+    bool submitCandidate(Individual candidate, int score, double seconds = 0.0);
+    void setArchive(CandidateArchive* archive);
+    // Archives a score that does not take part in selection, fidelity counts the rungs below full fidelity
+    void archiveScreening(const Individual& candidate, int score, int fidelity, double seconds);
     void setSurvivedIndividual(std::vector<double> yaw, std::vector<glm::vec3> offset);
-};
\ No newline at end of file
+    // Unscored individual, fitted to the spline basis if one is used
+    Individual createIndividual(std::vector<double> yaw, std::vector<glm::vec3> offset);
+    // One bump mutation of parent, index selects the random streams within the current generation
+    Individual mutateIndividual(const Individual& parent, int index);
+    int getBestScore();
+    std::vector<double> getBestYawSequence();
+    std::vector<glm::vec3> getBestOffsetSequence();
+    const std::vector<SurrogateStats>& getSurrogateStats();
+    // Everything needed to continue a run exactly, the random streams only depend on seed and generation.
+    // A full state holds all individuals and statistics, otherwise the survivors are only
+    // written if they changed since the last call and only the newest statistics entry is written.
+    void saveState(ByteWriter& writer, bool full);
+    bool loadState(ByteReader& reader);
+};
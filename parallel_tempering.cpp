@@ -0,0 +1,185 @@
+#include "parallel_tempering.h"
+
+ParallelTempering::ParallelTempering(Optimizer& optimizer, EvaluatorPool& pool, const Individual& root, int chain_amount, double min_temperature, double max_temperature, uint64_t seed)
+: optimizer(optimizer), pool(pool), seed(seed), swap_interval(1), swap_rounds(0), best(root), step(0)
+{
+    chain_amount = std::max(chain_amount, 1);
+    for (int k = 0; k < chain_amount; k++)
+    {
+        TemperingChain chain;
+        chain.current = root;
+        double fraction = chain_amount > 1 ? (double)k / (chain_amount - 1) : 0.0;
+        chain.temperature = min_temperature * pow(max_temperature / min_temperature, fraction);
+        chain.proposals = 0;
+        chain.accepted = 0;
+        chains.push_back(chain);
+    }
+    swap_attempts.assign(chain_amount - 1, 0);
+    swap_accepts.assign(chain_amount - 1, 0);
+    swap_probabilities.assign(chain_amount - 1, 0.5);
+}
+
+void ParallelTempering::setSwapInterval(int swap_interval)
+{
+    this->swap_interval = std::max(swap_interval, 1);
+}
+
+std::vector<int> ParallelTempering::evaluate(const std::vector<Individual>& candidates)
+{
+    for (int k = 0; k < (int)candidates.size(); k++)
+    {
+        pool.submit({ k, candidates[k].yaw_sequence, candidates[k].offset_sequence });
+    }
+
+    std::vector<int> scores(candidates.size(), 0);
+    size_t received = 0;
+    while (received < candidates.size())
+    {
+        EvaluationResult result;
+        pool.waitForResult(result);
+        scores[result.id] = result.score;
+        received++;
+    }
+    return scores;
+}
+
+void ParallelTempering::attemptSwaps()
+{
+    // The index past the last chain keeps this stream apart from the Metropolis streams
+    RngStream stream(seed, step, (uint32_t)chains.size(), RNG_PURPOSE_TEMPERING);
+
+    // Even and odd pairs alternate so every chain takes part in at most one swap per round
+    for (int k = swap_rounds % 2; k + 1 < (int)chains.size(); k += 2)
+    {
+        TemperingChain& colder = chains[k];
+        TemperingChain& hotter = chains[k + 1];
+        double exponent = (1.0 / colder.temperature - 1.0 / hotter.temperature) * (hotter.current.score - colder.current.score);
+        double probability = exponent >= 0.0 ? 1.0 : exp(exponent);
+
+        // The probability itself is a less noisy estimate than the outcome
+        swap_probabilities[k] = 0.9 * swap_probabilities[k] + 0.1 * probability;
+        swap_attempts[k]++;
+        if (stream.nextUniform() < probability)
+        {
+            std::swap(colder.current, hotter.current);
+            swap_accepts[k]++;
+        }
+    }
+    swap_rounds++;
+
+    adaptLadder();
+}
+
+void ParallelTempering::adaptLadder()
+{
+    size_t pair_amount = chains.size() - 1;
+    double mean_probability = 0.0;
+    for (double probability : swap_probabilities)
+    {
+        mean_probability += probability / pair_amount;
+    }
+
+    // Pairs that swap more often than average get wider log spacing, the total span is kept
+    double gain = 1.0 / (1.0 + 0.01 * swap_rounds);
+    double span = log(chains.back().temperature / chains.front().temperature);
+    std::vector<double> spacings(pair_amount);
+    double spacing_sum = 0.0;
+    for (size_t k = 0; k < pair_amount; k++)
+    {
+        spacings[k] = log(chains[k + 1].temperature / chains[k].temperature) * exp(gain * (swap_probabilities[k] - mean_probability));
+        spacing_sum += spacings[k];
+    }
+    for (size_t k = 0; k < pair_amount; k++)
+    {
+        chains[k + 1].temperature = chains[k].temperature * exp(spacings[k] * span / spacing_sum);
+    }
+}
+
+void ParallelTempering::run(int step_amount)
+{
+    auto start = std::chrono::steady_clock::now();
+    pool.start();
+
+    if (!best.evaluated)
+    {
+        best.score = evaluate(std::vector<Individual>(1, best))[0];
+        best.evaluated = true;
+        for (TemperingChain& chain : chains)
+        {
+            chain.current = best;
+        }
+    }
+
+    int chain_amount = (int)chains.size();
+    for (int s = 0; s < step_amount; s++)
+    {
+        std::vector<Individual> proposals(chain_amount);
+        for (int k = 0; k < chain_amount; k++)
+        {
+            proposals[k] = optimizer.mutateIndividual(chains[k].current, step * chain_amount + k);
+        }
+        std::vector<int> scores = evaluate(proposals);
+
+        // Metropolis acceptance on the score in pixels, higher is better
+        for (int k = 0; k < chain_amount; k++)
+        {
+            TemperingChain& chain = chains[k];
+            RngStream stream(seed, step, k, RNG_PURPOSE_TEMPERING);
+            proposals[k].score = scores[k];
+            proposals[k].evaluated = true;
+            double delta = scores[k] - chain.current.score;
+
+            chain.proposals++;
+            if (delta >= 0.0 || stream.nextUniform() < exp(delta / chain.temperature))
+            {
+                chain.current = proposals[k];
+                chain.accepted++;
+            }
+
+            if (scores[k] > best.score)
+            {
+                best = proposals[k];
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::cout << "Step " << step + 1 << " chain " << k << " temperature " << chain.temperature << " Pixel " << best.score << " after " << seconds << " s" << std::endl;
+            }
+        }
+        step++;
+
+        if (step % swap_interval == 0 && chain_amount > 1)
+        {
+            attemptSwaps();
+        }
+
+        if (step % 100 == 0)
+        {
+            std::cout << "Step " << step << " temperatures";
+            for (const TemperingChain& chain : chains)
+            {
+                std::cout << " " << chain.temperature << " (" << (double)chain.accepted / chain.proposals << ")";
+            }
+            std::cout << " swap rates";
+            for (size_t k = 0; k + 1 < chains.size(); k++)
+            {
+                std::cout << " " << getSwapRate(k);
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    pool.stop();
+}
+
+const Individual& ParallelTempering::getBest()
+{
+    return best;
+}
+
+const std::vector<TemperingChain>& ParallelTempering::getChains()
+{
+    return chains;
+}
+
+double ParallelTempering::getSwapRate(int pair)
+{
+    return swap_attempts[pair] > 0 ? (double)swap_accepts[pair] / swap_attempts[pair] : 0.0;
+}
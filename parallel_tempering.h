@@ -0,0 +1,61 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <chrono>
+
+#include "optimizer.h"
+#include "evaluator_pool.h"
+#include "rng.h"
+
+// State of one replica
+struct TemperingChain
+{
+    Individual current;
+    double temperature;
+    long long proposals;
+    long long accepted;
+};
+
+// Replica exchange over the motion space. Every chain runs Metropolis steps with
+// the optimizer's bump mutations at its own temperature, in pixels, so hot chains
+// accept worse motions and cross barriers the greedy selection cannot. All chains
+// propose at once and their candidates are evaluated in parallel by the pool.
+// Every swap_interval steps adjacent chains try to exchange their motions. The
+// coldest and hottest temperatures stay fixed while the log spacing in between
+// adapts until every adjacent pair swaps equally often, so motions travel the
+// whole ladder. The adaptation decays so the ladder settles.
+class ParallelTempering
+{
+    private:
+    Optimizer& optimizer;
+    EvaluatorPool& pool;
+    uint64_t seed;
+
+    std::vector<TemperingChain> chains;
+    int swap_interval;
+    // Per adjacent pair, index k swaps chains k and k + 1
+    std::vector<long long> swap_attempts;
+    std::vector<long long> swap_accepts;
+    // Smoothed swap acceptance probabilities the ladder adapts to
+    std::vector<double> swap_probabilities;
+    int swap_rounds;
+
+    Individual best;
+    int step;
+
+    std::vector<int> evaluate(const std::vector<Individual>& candidates);
+    void attemptSwaps();
+    void adaptLadder();
+
+    protected:
+    public:
+    // Temperatures start geometric from min_temperature to max_temperature
+    ParallelTempering(Optimizer& optimizer, EvaluatorPool& pool, const Individual& root, int chain_amount, double min_temperature, double max_temperature, uint64_t seed);
+    void setSwapInterval(int swap_interval);
+    void run(int step_amount);
+    const Individual& getBest();
+    const std::vector<TemperingChain>& getChains();
+    double getSwapRate(int pair);
+};
@@ -0,0 +1,253 @@
+#include "perf_counters.h"
+
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+std::atomic<bool> perf_counters_enabled(false);
+
+static const char* phase_names[PERF_PHASE_AMOUNT] = { "mutation", "render", "readback", "count", "select" };
+static const uint64_t counter_configs[PERF_COUNTER_AMOUNT] =
+{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+// Every last level cache miss fills one line
+static const uint64_t cache_line_size = 64;
+
+// Counter group of one thread and what its scopes have accumulated
+struct PerfThreadCounters
+{
+    int fds[PERF_COUNTER_AMOUNT];
+    bool open;
+    std::atomic<uint64_t> values[PERF_PHASE_AMOUNT][PERF_COUNTER_AMOUNT];
+    std::atomic<uint64_t> nanoseconds[PERF_PHASE_AMOUNT];
+    std::atomic<uint64_t> scopes[PERF_PHASE_AMOUNT];
+
+    PerfThreadCounters();
+    ~PerfThreadCounters();
+};
+
+// Owns the counter group of one thread, closes it and keeps its totals when the thread exits
+struct PerfThreadSlot
+{
+    std::unique_ptr<PerfThreadCounters> counters;
+
+    ~PerfThreadSlot();
+};
+
+static std::mutex threads_mutex;
+static std::vector<PerfThreadCounters*> threads;
+// Totals of the threads that exited since the last summary
+static PerfSummary retired = {};
+static thread_local PerfThreadSlot thread_slot;
+
+static long openPerfEvent(perf_event_attr& attr, int group_fd)
+{
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+// Opens the group on the calling thread, errno tells why it failed
+static bool openGroup(int* fds)
+{
+    for (int c = 0; c < PERF_COUNTER_AMOUNT; c++)
+    {
+        fds[c] = -1;
+    }
+    for (int c = 0; c < PERF_COUNTER_AMOUNT; c++)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = counter_configs[c];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = c == 0 ? 1 : 0;
+        // User space only, most containers allow nothing else
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fds[c] = (int)openPerfEvent(attr, c == 0 ? -1 : fds[0]);
+        if (fds[c] < 0)
+        {
+            int error = errno;
+            for (int o = 0; o < c; o++)
+            {
+                close(fds[o]);
+                fds[o] = -1;
+            }
+            errno = error;
+            return false;
+        }
+    }
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+// Fills the counter values followed by the enabled and running times
+static bool readGroup(const int* fds, uint64_t* values)
+{
+    uint64_t buffer[3 + PERF_COUNTER_AMOUNT];
+    if (read(fds[0], buffer, sizeof(buffer)) != (ssize_t)sizeof(buffer) || buffer[0] != PERF_COUNTER_AMOUNT)
+    {
+        return false;
+    }
+    for (int c = 0; c < PERF_COUNTER_AMOUNT; c++)
+    {
+        values[c] = buffer[3 + c];
+    }
+    values[PERF_COUNTER_AMOUNT] = buffer[1];
+    values[PERF_COUNTER_AMOUNT + 1] = buffer[2];
+    return true;
+}
+
+PerfThreadCounters::PerfThreadCounters()
+{
+    open = openGroup(fds);
+    for (int p = 0; p < PERF_PHASE_AMOUNT; p++)
+    {
+        for (int c = 0; c < PERF_COUNTER_AMOUNT; c++)
+        {
+            values[p][c].store(0);
+        }
+        nanoseconds[p].store(0);
+        scopes[p].store(0);
+    }
+}
+
+PerfThreadCounters::~PerfThreadCounters()
+{
+    for (int c = 0; c < PERF_COUNTER_AMOUNT; c++)
+    {
+        if (fds[c] >= 0)
+        {
+            close(fds[c]);
+        }
+    }
+}
+
+// Moves what the scopes of a thread accumulated into summary
+static void drainCounters(PerfThreadCounters& counters, PerfSummary& summary)
+{
+    for (int p = 0; p < PERF_PHASE_AMOUNT; p++)
+    {
+        for (int c = 0; c < PERF_COUNTER_AMOUNT; c++)
+        {
+            summary.values[p][c] += counters.values[p][c].exchange(0, std::memory_order_relaxed);
+        }
+        summary.nanoseconds[p] += counters.nanoseconds[p].exchange(0, std::memory_order_relaxed);
+        summary.scopes[p] += counters.scopes[p].exchange(0, std::memory_order_relaxed);
+    }
+}
+
+PerfThreadSlot::~PerfThreadSlot()
+{
+    if (!counters)
+    {
+        return;
+    }
+    // Short-lived workers, e.g. one set per multi-fidelity rung, would otherwise pile up open groups
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    drainCounters(*counters, retired);
+    threads.erase(std::remove(threads.begin(), threads.end(), counters.get()), threads.end());
+}
+
+static PerfThreadCounters* getThreadCounters()
+{
+    if (!thread_slot.counters)
+    {
+        thread_slot.counters.reset(new PerfThreadCounters());
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        threads.push_back(thread_slot.counters.get());
+    }
+    return thread_slot.counters.get();
+}
+
+bool enablePerfCounters()
+{
+    PerfThreadCounters* counters = getThreadCounters();
+    if (!counters->open)
+    {
+        std::cerr << "Hardware counters are unavailable (" << strerror(errno) << "), running without them" << std::endl;
+        return false;
+    }
+    perf_counters_enabled.store(true);
+    return true;
+}
+
+void beginPerfScope(uint64_t* start)
+{
+    PerfThreadCounters* counters = getThreadCounters();
+    if (!counters->open || !readGroup(counters->fds, start))
+    {
+        start[PERF_COUNTER_AMOUNT] = 0;
+        start[PERF_COUNTER_AMOUNT + 1] = UINT64_MAX;
+    }
+}
+
+void endPerfScope(PerfPhase phase, const uint64_t* start)
+{
+    PerfThreadCounters* counters = getThreadCounters();
+    uint64_t end[PERF_COUNTER_AMOUNT + 2];
+    if (start[PERF_COUNTER_AMOUNT + 1] == UINT64_MAX || !readGroup(counters->fds, end))
+    {
+        return;
+    }
+
+    uint64_t enabled = end[PERF_COUNTER_AMOUNT] - start[PERF_COUNTER_AMOUNT];
+    uint64_t running = end[PERF_COUNTER_AMOUNT + 1] - start[PERF_COUNTER_AMOUNT + 1];
+    // The group never got onto the PMU during the scope, there is nothing to scale
+    if (running == 0)
+    {
+        return;
+    }
+    double scale = (double)enabled / running;
+    for (int c = 0; c < PERF_COUNTER_AMOUNT; c++)
+    {
+        counters->values[phase][c].fetch_add((uint64_t)((end[c] - start[c]) * scale), std::memory_order_relaxed);
+    }
+    counters->nanoseconds[phase].fetch_add(enabled, std::memory_order_relaxed);
+    counters->scopes[phase].fetch_add(1, std::memory_order_relaxed);
+}
+
+void takePerfSummary(PerfSummary& summary)
+{
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    summary = retired;
+    memset(&retired, 0, sizeof(retired));
+    for (PerfThreadCounters* counters : threads)
+    {
+        drainCounters(*counters, summary);
+    }
+}
+
+void printPerfSummary(const PerfSummary& summary, const std::string& label, std::ostream& output)
+{
+    for (int p = 0; p < PERF_PHASE_AMOUNT; p++)
+    {
+        if (summary.scopes[p] == 0)
+        {
+            continue;
+        }
+        const uint64_t* values = summary.values[p];
+        double seconds = summary.nanoseconds[p] * 1e-9;
+        double ipc = values[PERF_COUNTER_CYCLES] > 0 ? (double)values[PERF_COUNTER_INSTRUCTIONS] / values[PERF_COUNTER_CYCLES] : 0.0;
+        double miss_bytes = (double)values[PERF_COUNTER_CACHE_MISSES] * cache_line_size;
+        double branch_miss_rate = values[PERF_COUNTER_BRANCHES] > 0 ? (double)values[PERF_COUNTER_BRANCH_MISSES] / values[PERF_COUNTER_BRANCHES] : 0.0;
+
+        output << label << " perf " << phase_names[p] << ": " << summary.scopes[p] << " scopes " << seconds << " s on CPU"
+            << " cycles " << values[PERF_COUNTER_CYCLES] << " IPC " << ipc
+            << " cache misses " << values[PERF_COUNTER_CACHE_MISSES] << " (" << (seconds > 0.0 ? miss_bytes / seconds * 1e-6 : 0.0) << " MB/s)"
+            << " branch misses " << branch_miss_rate * 100.0 << "%" << std::endl;
+    }
+}
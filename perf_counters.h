@@ -0,0 +1,86 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// Phases hardware counters are attributed to, scopes of different phases must not nest
+enum PerfPhase
+{
+    PERF_PHASE_MUTATION = 0,
+    PERF_PHASE_RENDER = 1,
+    PERF_PHASE_READBACK = 2,
+    PERF_PHASE_COUNT = 3,
+    PERF_PHASE_SELECT = 4,
+    PERF_PHASE_AMOUNT = 5
+};
+
+enum PerfCounter
+{
+    PERF_COUNTER_CYCLES = 0,
+    PERF_COUNTER_INSTRUCTIONS = 1,
+    PERF_COUNTER_CACHE_MISSES = 2,
+    PERF_COUNTER_BRANCHES = 3,
+    PERF_COUNTER_BRANCH_MISSES = 4,
+    PERF_COUNTER_AMOUNT = 5
+};
+
+// Counter totals of every phase, already scaled up where the kernel multiplexed the group
+struct PerfSummary
+{
+    uint64_t values[PERF_PHASE_AMOUNT][PERF_COUNTER_AMOUNT];
+    // Time the measured threads were on a CPU, sleeps inside a scope do not count
+    uint64_t nanoseconds[PERF_PHASE_AMOUNT];
+    uint64_t scopes[PERF_PHASE_AMOUNT];
+};
+
+extern std::atomic<bool> perf_counters_enabled;
+
+// Opens a counter group on the calling thread to check that perf events are usable.
+// Returns false with a message if they are not, e.g. in a container that forbids them,
+// and every PerfScope stays a no-op.
+bool enablePerfCounters();
+// Adds the counters of all threads since the last call into summary and starts over
+void takePerfSummary(PerfSummary& summary);
+// One line per phase that ran, with IPC, cache misses and their bytes, and the branch miss rate
+void printPerfSummary(const PerfSummary& summary, const std::string& label, std::ostream& output);
+
+void beginPerfScope(uint64_t* start);
+void endPerfScope(PerfPhase phase, const uint64_t* start);
+
+// Attributes the counters of the calling thread between construction and destruction to phase.
+// Each thread gets its own counter group on first use, closed when the thread exits. A scope costs two reads of the
+// group, about a microsecond, so scopes wrap whole phases rather than single calls.
+class PerfScope
+{
+    private:
+    PerfPhase phase;
+    bool active;
+    // Raw group values plus the enabled and running times
+    uint64_t start[PERF_COUNTER_AMOUNT + 2];
+
+    protected:
+    public:
+    explicit PerfScope(PerfPhase phase)
+    : phase(phase), active(false)
+    {
+        if (perf_counters_enabled.load(std::memory_order_relaxed))
+        {
+            active = true;
+            beginPerfScope(start);
+        }
+    }
+
+    ~PerfScope()
+    {
+        if (active)
+        {
+            endPerfScope(phase, start);
+        }
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+};
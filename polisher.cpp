@@ -0,0 +1,130 @@
+#include "polisher.h"
+
+// Line searches stop refining below these steps, about a tenth of a pixel at 1400 pixels
+static const double min_yaw_step = 1e-5;
+static const double min_offset_step = 1e-4;
+
+Polisher::Polisher(int frame_width, int frame_height, glm::vec3 anchor)
+: coverage(frame_width, frame_height, anchor), max_binding_frames(64), yaw_step(1e-3), offset_step(1e-3), probe_amount(0)
+{
+
+}
+
+void Polisher::setMaxBindingFrames(int max_binding_frames)
+{
+    this->max_binding_frames = std::max(max_binding_frames, 1);
+}
+
+void Polisher::setSteps(double yaw_step, double offset_step)
+{
+    this->yaw_step = yaw_step;
+    this->offset_step = offset_step;
+}
+
+bool Polisher::lineSearch(int frame, int coordinate, double step)
+{
+    int best = coverage.getRemainingPixel();
+    bool improved = false;
+
+    for (int direction = 1; direction >= -1 && !improved; direction -= 2)
+    {
+        // Keep doubling the step while the score keeps rising
+        double distance = direction * step;
+        while (true)
+        {
+            double yaw = coverage.getYawSequence()[frame];
+            glm::vec3 offset = coverage.getOffsetSequence()[frame];
+            if (coordinate == 0)
+            {
+                yaw += distance;
+            }
+            else
+            {
+                offset[coordinate - 1] += (float)distance;
+            }
+
+            int score = coverage.probeFrame(frame, yaw, offset);
+            probe_amount++;
+            if (score <= best)
+            {
+                break;
+            }
+
+            coverage.moveFrame(frame, yaw, offset);
+            best = score;
+            improved = true;
+            distance *= 2.0;
+        }
+    }
+
+    return improved;
+}
+
+int Polisher::polish(const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence, int max_sweeps)
+{
+    auto start = std::chrono::steady_clock::now();
+    coverage.build(yaw_sequence, offset_sequence);
+    std::cout << "Polish start Pixel " << coverage.getRemainingPixel() << std::endl;
+
+    double yaw_size = yaw_step;
+    double offset_size = offset_step;
+    for (int sweep = 0; sweep < max_sweeps; sweep++)
+    {
+        std::vector<int> kills = coverage.uniqueKills();
+        std::vector<int> binding;
+        for (int i = 0; i < (int)kills.size(); i++)
+        {
+            if (kills[i] > 0)
+            {
+                binding.push_back(i);
+            }
+        }
+        std::stable_sort(binding.begin(), binding.end(), [&kills](int a, int b)
+        {
+            return kills[a] > kills[b];
+        });
+        if ((int)binding.size() > max_binding_frames)
+        {
+            binding.resize(max_binding_frames);
+        }
+
+        int improvements = 0;
+        for (int frame : binding)
+        {
+            improvements += lineSearch(frame, 0, yaw_size);
+            improvements += lineSearch(frame, 1, offset_size);
+            improvements += lineSearch(frame, 2, offset_size);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Polish sweep " << sweep + 1 << " binding frames " << binding.size() << " improvements " << improvements
+            << " Pixel " << coverage.getRemainingPixel() << " probes " << probe_amount << " after " << seconds << " s" << std::endl;
+
+        if (improvements == 0)
+        {
+            yaw_size /= 2.0;
+            offset_size /= 2.0;
+            if (yaw_size < min_yaw_step && offset_size < min_offset_step)
+            {
+                break;
+            }
+        }
+    }
+
+    return coverage.getRemainingPixel();
+}
+
+const std::vector<double>& Polisher::getYawSequence()
+{
+    return coverage.getYawSequence();
+}
+
+const std::vector<glm::vec3>& Polisher::getOffsetSequence()
+{
+    return coverage.getOffsetSequence();
+}
+
+long long Polisher::getProbeAmount()
+{
+    return probe_amount;
+}
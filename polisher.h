@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "libs/glm/glm.hpp"
+
+#include "coverage_map.h"
+
+// Local search for the end of a run, when random whole-sequence bumps stop paying off.
+// Only frames that kill pixels no other frame covers can change the score, so each
+// sweep collects those binding frames from the coverage map and runs expanding line
+// searches on their yaw, x and y one coordinate at a time. Every probe moves a single
+// frame and is scored incrementally by the coverage map.
+class Polisher
+{
+    private:
+    CoverageMap coverage;
+
+    // Binding frames searched per sweep, the ones with the most unique kills first
+    int max_binding_frames;
+    double yaw_step;
+    double offset_step;
+    long long probe_amount;
+
+    bool lineSearch(int frame, int coordinate, double step);
+
+    protected:
+    public:
+    Polisher(int frame_width, int frame_height, glm::vec3 anchor);
+    void setMaxBindingFrames(int max_binding_frames);
+    // First step of the line searches, halved whenever a sweep finds nothing
+    void setSteps(double yaw_step, double offset_step);
+    // Returns the remaining pixels after polishing
+    int polish(const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence, int max_sweeps);
+    const std::vector<double>& getYawSequence();
+    const std::vector<glm::vec3>& getOffsetSequence();
+    long long getProbeAmount();
+};
@@ -1,49 +1,104 @@
 #include "renderer.h"
 
+#include "trace.h"
+#include "perf_counters.h"
+
 Renderer::Renderer(int frame_width, int frame_height, SDL_Window* window, GLuint shaderProgram)
-: FRAME_WIDTH(frame_width), FRAME_HEIGHT(frame_height), window(window), shaderProgram(shaderProgram)
+: FRAME_WIDTH(frame_width), FRAME_HEIGHT(frame_height), window(window), shaderProgram(shaderProgram), gpu_timer(nullptr)
 {
    
 }
 
-int Renderer::Render(int time_resolution, glm::vec3 anchor, std::vector<double> yaw_sequence, std::vector<glm::vec3> offset_sequence)
+void Renderer::setGpuTimer(GpuTimer* gpu_timer)
 {
-    // Clean window
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    this->gpu_timer = gpu_timer;
+}
 
-    // Render and stack frames
-    for (int i = 0; i < time_resolution; i++)
+int Renderer::Render(int time_resolution, glm::vec3 anchor, std::vector<double> yaw_sequence, std::vector<glm::vec3> offset_sequence)
+{
+    TraceSpan render_span("Renderer::Render");
+    if (gpu_timer)
     {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, offset_sequence[i]);
-        model = glm::translate(model, anchor);
-        model = glm::rotate(model, float(yaw_sequence[i]), glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::translate(model, -anchor);
-
-        unsigned int modelUniformLocation = glGetUniformLocation(shaderProgram, "model");
-        glUniformMatrix4fv(modelUniformLocation, 1, GL_FALSE, glm::value_ptr(model));
-        
-        glDrawArrays(GL_TRIANGLES, 0, 18);
+        gpu_timer->beginEvaluation();
     }
-    SDL_GL_SwapWindow(window);
 
-    SDL_Delay(1);
+    {
+        PerfScope perf_scope(PERF_PHASE_RENDER);
+
+        // Submission only queues the commands, the driver may do the work in the swap or the read
+        {
+            TraceSpan span("render/submit");
+
+            // Clean window
+            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            if (gpu_timer)
+            {
+                gpu_timer->endStage(GPU_STAGE_CLEAR);
+            }
+
+            // Render and stack frames
+            for (int i = 0; i < time_resolution; i++)
+            {
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, offset_sequence[i]);
+                model = glm::translate(model, anchor);
+                model = glm::rotate(model, float(yaw_sequence[i]), glm::vec3(0.0f, 0.0f, 1.0f));
+                model = glm::translate(model, -anchor);
+
+                unsigned int modelUniformLocation = glGetUniformLocation(shaderProgram, "model");
+                glUniformMatrix4fv(modelUniformLocation, 1, GL_FALSE, glm::value_ptr(model));
+                
+                glDrawArrays(GL_TRIANGLES, 0, hallway_wall_amount * 6);
+            }
+            if (gpu_timer)
+            {
+                gpu_timer->endStage(GPU_STAGE_DRAW);
+            }
+        }
+        {
+            TraceSpan span("render/swap");
+            SDL_GL_SwapWindow(window);
+            if (gpu_timer)
+            {
+                gpu_timer->endStage(GPU_STAGE_SWAP);
+            }
+        }
+        {
+            TraceSpan span("render/delay");
+            SDL_Delay(1);
+        }
+    }
 
     // Count percentage remaining in clear color
     int totalPixels = FRAME_WIDTH * FRAME_HEIGHT;
-    int clearColorPixels = 0;
     std::vector<GLubyte> pixelData(totalPixels * 4); // RGBA format
-    glReadBuffer(GL_FRONT_LEFT);
-    glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixelData.data());
+    {
+        TraceSpan span("render/read_pixels");
+        PerfScope perf_scope(PERF_PHASE_READBACK);
+        glReadBuffer(GL_FRONT_LEFT);
+        glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixelData.data());
+        if (gpu_timer)
+        {
+            gpu_timer->endStage(GPU_STAGE_READBACK);
+            gpu_timer->endEvaluation();
+        }
+    }
+
+    TraceSpan span("render/count_pixels");
+    PerfScope perf_scope(PERF_PHASE_COUNT);
+    return countClearColorPixels(pixelData.data(), totalPixels);
+}
 
-    for (int i = 0; i < totalPixels * 4; i += 4)
+int countClearColorPixels(const GLubyte* pixel_data, int pixel_amount)
+{
+    int clearColorPixels = 0;
+    for (int i = 0; i < pixel_amount * 4; i += 4)
     {
-        if (pixelData[i] == 255 && pixelData[i + 1] == 255 && pixelData[i + 2] == 255 && pixelData[i + 3] == 255) 
+        if (pixel_data[i] == 255 && pixel_data[i + 1] == 255 && pixel_data[i + 2] == 255 && pixel_data[i + 3] == 255) 
         {
             clearColorPixels++;
         }
     }
-
     return clearColorPixels;
 }
\ No newline at end of file
@@ -13,12 +13,16 @@
 #include "libs/glm/gtc/matrix_transform.hpp"
 #include "libs/glm/gtc/type_ptr.hpp"
 #include "util.h"
+#include "hallway.h"
+#include "gpu_timer.h"
 
 class Renderer
 {
     private:
     GLuint shaderProgram;
     SDL_Window* window;
+    // GPU timestamps of every evaluation if set
+    GpuTimer* gpu_timer;
 
     const int FRAME_WIDTH;
     const int FRAME_HEIGHT;
@@ -26,5 +30,9 @@ class Renderer
     protected:
     public:
     Renderer(int frame_width, int frame_height, SDL_Window* window, GLuint shaderProgram);
+    void setGpuTimer(GpuTimer* gpu_timer);
     int Render(int time_resolution, glm::vec3 anchor, std::vector<double> yaw_sequence, std::vector<glm::vec3> offset_sequence);
-};
\ No newline at end of file
+};
+
+// Number of RGBA pixels that still hold the white clear color
+int countClearColorPixels(const GLubyte* pixel_data, int pixel_amount);
\ No newline at end of file
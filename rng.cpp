@@ -0,0 +1,190 @@
+#include "rng.h"
+
+static const uint32_t philox_m0 = 0xD2511F53;
+static const uint32_t philox_m1 = 0xCD9E8D57;
+static const uint32_t philox_w0 = 0x9E3779B9;
+static const uint32_t philox_w1 = 0xBB67AE85;
+static const int philox_rounds = 10;
+
+// Blocks computed together by the batch path, laid out so the rounds vectorize
+static const int rng_lanes = 8;
+
+static inline double wordsToUniform(uint32_t a, uint32_t b)
+{
+    return ((a >> 5) * 67108864.0 + (b >> 6)) * (1.0 / 9007199254740992.0);
+}
+
+// Philox4x32 on rng_lanes counters at once, the lanes only differ in the first counter word
+static void philoxLanes(const uint32_t* key, const uint32_t* counter, uint32_t first_word, uint32_t out[4][rng_lanes])
+{
+    uint32_t c0[rng_lanes], c1[rng_lanes], c2[rng_lanes], c3[rng_lanes];
+    for (int l = 0; l < rng_lanes; l++)
+    {
+        c0[l] = first_word + (uint32_t)l;
+        c1[l] = counter[1];
+        c2[l] = counter[2];
+        c3[l] = counter[3];
+    }
+
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int r = 0; r < philox_rounds; r++)
+    {
+        for (int l = 0; l < rng_lanes; l++)
+        {
+            uint64_t p0 = (uint64_t)philox_m0 * c0[l];
+            uint64_t p1 = (uint64_t)philox_m1 * c2[l];
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1[l] ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3[l] ^ k1;
+            c1[l] = (uint32_t)p1;
+            c3[l] = (uint32_t)p0;
+            c0[l] = n0;
+            c2[l] = n2;
+        }
+        k0 += philox_w0;
+        k1 += philox_w1;
+    }
+
+    for (int l = 0; l < rng_lanes; l++)
+    {
+        out[0][l] = c0[l];
+        out[1][l] = c1[l];
+        out[2][l] = c2[l];
+        out[3][l] = c3[l];
+    }
+}
+
+RngStream::RngStream(uint64_t seed, uint32_t generation, uint32_t individual, uint32_t purpose)
+: block_position(4), has_spare_normal(false), spare_normal(0.0)
+{
+    key[0] = (uint32_t)seed;
+    key[1] = (uint32_t)(seed >> 32);
+    counter[0] = 0;
+    counter[1] = generation;
+    counter[2] = individual;
+    counter[3] = purpose;
+}
+
+void RngStream::nextBlock()
+{
+    uint32_t c0 = counter[0];
+    uint32_t c1 = counter[1];
+    uint32_t c2 = counter[2];
+    uint32_t c3 = counter[3];
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+
+    for (int r = 0; r < philox_rounds; r++)
+    {
+        uint64_t p0 = (uint64_t)philox_m0 * c0;
+        uint64_t p1 = (uint64_t)philox_m1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += philox_w0;
+        k1 += philox_w1;
+    }
+
+    block[0] = c0;
+    block[1] = c1;
+    block[2] = c2;
+    block[3] = c3;
+    block_position = 0;
+    counter[0]++;
+}
+
+uint32_t RngStream::nextUInt()
+{
+    if (block_position == 4)
+    {
+        nextBlock();
+    }
+    return block[block_position++];
+}
+
+double RngStream::nextUniform()
+{
+    uint32_t a = nextUInt();
+    uint32_t b = nextUInt();
+    return wordsToUniform(a, b);
+}
+
+double RngStream::nextUniform(double lower_bound, double upper_bound)
+{
+    return lower_bound + (upper_bound - lower_bound) * nextUniform();
+}
+
+double RngStream::nextNormal()
+{
+    if (has_spare_normal)
+    {
+        has_spare_normal = false;
+        return spare_normal;
+    }
+
+    // Box-Muller, 1 - u keeps the logarithm finite
+    double u1 = 1.0 - nextUniform();
+    double u2 = nextUniform();
+    double radius = sqrt(-2.0 * log(u1));
+    spare_normal = radius * sin(2.0 * M_PI * u2);
+    has_spare_normal = true;
+    return radius * cos(2.0 * M_PI * u2);
+}
+
+void RngStream::fillUniform(double* out, int amount)
+{
+    int i = 0;
+
+    // Finish the words left in the current block so the stream stays sequential
+    if (block_position % 2 == 0)
+    {
+        while (i < amount && block_position != 4)
+        {
+            out[i++] = nextUniform();
+        }
+    }
+
+    uint32_t words[4][rng_lanes];
+    while (block_position == 4 && amount - i >= 2 * rng_lanes)
+    {
+        philoxLanes(key, counter, counter[0], words);
+        for (int l = 0; l < rng_lanes; l++)
+        {
+            out[i + 2 * l] = wordsToUniform(words[0][l], words[1][l]);
+            out[i + 2 * l + 1] = wordsToUniform(words[2][l], words[3][l]);
+        }
+        counter[0] += rng_lanes;
+        i += 2 * rng_lanes;
+    }
+
+    while (i < amount)
+    {
+        out[i++] = nextUniform();
+    }
+}
+
+void RngStream::fillNormal(double* out, int amount)
+{
+    int pair_amount = (amount + 1) / 2;
+    double uniforms[2 * rng_lanes];
+
+    for (int p = 0; p < pair_amount; p += rng_lanes)
+    {
+        int batch = pair_amount - p < rng_lanes ? pair_amount - p : rng_lanes;
+        fillUniform(uniforms, 2 * batch);
+        for (int l = 0; l < batch; l++)
+        {
+            double radius = sqrt(-2.0 * log(1.0 - uniforms[2 * l]));
+            double angle = 2.0 * M_PI * uniforms[2 * l + 1];
+            int index = 2 * (p + l);
+            out[index] = radius * cos(angle);
+            if (index + 1 < amount)
+            {
+                out[index + 1] = radius * sin(angle);
+            }
+        }
+    }
+}
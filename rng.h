@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+// What a stream of random numbers is used for, part of the stream key
+enum RngPurpose
+{
+    RNG_PURPOSE_YAW = 0,
+    RNG_PURPOSE_OFFSET = 1,
+    RNG_PURPOSE_SELECTION = 2,
+    RNG_PURPOSE_RECOMBINATION = 3,
+    RNG_PURPOSE_TEMPERING = 4
+};
+
+// Counter-based random stream on top of Philox4x32-10. The run seed is the Philox key
+// and (generation, individual, purpose) fill the upper counter words, so every key
+// maps to an independent stream that can be created anywhere without shared state.
+// Results therefore never depend on which thread draws them or in what order.
+class RngStream
+{
+    private:
+    uint32_t key[2];
+    uint32_t counter[4];
+
+    // Unconsumed words of the current block
+    uint32_t block[4];
+    int block_position;
+
+    bool has_spare_normal;
+    double spare_normal;
+
+    void nextBlock();
+
+    protected:
+    public:
+    RngStream(uint64_t seed, uint32_t generation, uint32_t individual, uint32_t purpose);
+    uint32_t nextUInt();
+    // Uniform in [0, 1) with 53 bits of precision
+    double nextUniform();
+    double nextUniform(double lower_bound, double upper_bound);
+    double nextNormal();
+    // Batch generation, whole Philox blocks are computed lane-parallel
+    void fillUniform(double* out, int amount);
+    void fillNormal(double* out, int amount);
+};
@@ -1,2 +1,7 @@
-g++ -o sofa main.cpp renderer.cpp optimizer.cpp -lSDL2 -lGL -lGLEW
-./sofa
\ No newline at end of file
+./embed_shaders.sh
+g++ -O2 -pthread -o sofa main.cpp renderer.cpp optimizer.cpp soft_rasterizer.cpp spline_basis.cpp rng.cpp fitness_cache.cpp surrogate.cpp cpu_rasterizer.cpp steady_state.cpp checkpoint.cpp multi_fidelity.cpp evaluator_pool.cpp sweep.cpp coverage_map.cpp polisher.cpp parallel_tempering.cpp seed_motions.cpp motion_file.cpp telemetry.cpp candidate_archive.cpp shader_program.cpp trace.cpp perf_counters.cpp gpu_timer.cpp live_stats.cpp -lSDL2 -lGL -lGLEW -lrt
+g++ -O2 -pthread -o sofa-telemetry telemetry_decode.cpp telemetry.cpp
+g++ -O2 -o sofa-top sofa_top.cpp live_stats.cpp -lrt
+g++ -O2 -pthread -o sofa-bench benchmark_suite.cpp benchmark.cpp renderer.cpp optimizer.cpp cpu_rasterizer.cpp soft_rasterizer.cpp spline_basis.cpp rng.cpp surrogate.cpp coverage_map.cpp seed_motions.cpp motion_file.cpp shader_program.cpp candidate_archive.cpp trace.cpp perf_counters.cpp gpu_timer.cpp gl_evaluator.cpp -lSDL2 -lGL -lGLEW
+g++ -O2 -pthread -o sofa-golden golden_run.cpp renderer.cpp optimizer.cpp cpu_rasterizer.cpp soft_rasterizer.cpp spline_basis.cpp rng.cpp surrogate.cpp coverage_map.cpp seed_motions.cpp motion_file.cpp shader_program.cpp candidate_archive.cpp trace.cpp perf_counters.cpp gpu_timer.cpp gl_evaluator.cpp -lSDL2 -lGL -lGLEW
+./sofa
@@ -0,0 +1,380 @@
+#include "seed_motions.h"
+
+#include <algorithm>
+
+bool parseSeedMotion(const std::string& name, SeedMotion& motion)
+{
+    if (name == "file")
+    {
+        motion = SEED_MOTION_FILE;
+    }
+    else if (name == "half-disk")
+    {
+        motion = SEED_MOTION_HALF_DISK;
+    }
+    else if (name == "hammersley")
+    {
+        motion = SEED_MOTION_HAMMERSLEY;
+    }
+    else if (name == "gerver")
+    {
+        motion = SEED_MOTION_GERVER;
+    }
+    else if (name == "romik")
+    {
+        motion = SEED_MOTION_ROMIK;
+    }
+    else
+    {
+        std::cerr << "Unknown seed motion: " << name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char* getSeedMotionName(SeedMotion motion)
+{
+    switch (motion)
+    {
+        case SEED_MOTION_HALF_DISK:
+            return "half-disk";
+        case SEED_MOTION_HAMMERSLEY:
+            return "hammersley";
+        case SEED_MOTION_GERVER:
+            return "gerver";
+        case SEED_MOTION_ROMIK:
+            return "romik";
+        default:
+            return "file";
+    }
+}
+
+// Gerver's sofa is described in units of the hallway width by its rotation path,
+// the inner corner x(t) of the hallway turned by t. With the wall normals
+// m = (cos t, sin t) and n = (-sin t, cos t) the corner sits at f m + k n. It
+// moves by a = f' - k along m and by b = f + k' along n, and the outer walls
+// touch the sofa along arcs of radius f + f'' + 1 and k + k'' + 1.
+//
+// The sofa touches both outer walls throughout the turn, the inner wall of the
+// arm it leaves until theta, the inner corner from phi to pi / 2 - phi and the
+// inner wall of the arm it enters from pi / 2 - theta. The outer wall facing m
+// only pivots about the sofa's end until phi and the one facing n does from
+// pi / 2 - phi on. In every phase the pressure of the walls on the sofa
+// balances, which is the contact condition of that phase.
+struct GerverConstants
+{
+    double A;
+    double B;
+    double phi;
+    double theta;
+};
+
+// Romik's conditions on the constants: the phases join where they change and
+// the path is symmetric about pi / 4
+static void getGerverResiduals(const double* constants, double* residuals)
+{
+    double A = constants[0];
+    double B = constants[1];
+    double phi = constants[2];
+    double theta = constants[3];
+    residuals[0] = A * (cos(theta) - cos(phi)) - 2.0 * B * sin(phi) + (theta - phi - 1.0) * cos(theta) - sin(theta) + cos(phi) + sin(phi);
+    residuals[1] = A * (3.0 * sin(theta) + sin(phi)) - 2.0 * B * cos(phi) + 3.0 * (theta - phi - 1.0) * sin(theta) + 3.0 * cos(theta) - sin(phi) + cos(phi);
+    residuals[2] = A * cos(phi) - (sin(phi) + 0.5 - 0.5 * cos(phi) + B * sin(phi));
+    residuals[3] = (A + M_PI / 2.0 - phi - theta) - (B - 0.5 * (theta - phi) * (1.0 + A) - 0.25 * (theta - phi) * (theta - phi));
+}
+
+// Newton's method from Gerver's values rounded to three digits
+static GerverConstants solveGerverConstants()
+{
+    double constants[4] = { 0.094, 1.399, 0.039, 0.681 };
+    for (int iteration = 0; iteration < 20; iteration++)
+    {
+        double residuals[4];
+        getGerverResiduals(constants, residuals);
+        double system[4][5];
+        for (int j = 0; j < 4; j++)
+        {
+            double shifted[4] = { constants[0], constants[1], constants[2], constants[3] };
+            shifted[j] += 1e-7;
+            double shifted_residuals[4];
+            getGerverResiduals(shifted, shifted_residuals);
+            for (int i = 0; i < 4; i++)
+            {
+                system[i][j] = (shifted_residuals[i] - residuals[i]) / 1e-7;
+            }
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            system[i][4] = -residuals[i];
+        }
+        for (int column = 0; column < 4; column++)
+        {
+            int pivot = column;
+            for (int i = column + 1; i < 4; i++)
+            {
+                if (fabs(system[i][column]) > fabs(system[pivot][column]))
+                {
+                    pivot = i;
+                }
+            }
+            for (int j = 0; j < 5; j++)
+            {
+                std::swap(system[column][j], system[pivot][j]);
+            }
+            for (int i = 0; i < 4; i++)
+            {
+                if (i == column)
+                {
+                    continue;
+                }
+                double factor = system[i][column] / system[column][column];
+                for (int j = column; j < 5; j++)
+                {
+                    system[i][j] -= factor * system[column][j];
+                }
+            }
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            constants[i] += system[i][4] / system[i][i];
+        }
+    }
+    return { constants[0], constants[1], constants[2], constants[3] };
+}
+
+// f'' and k'' for the state (f, f', k, k') in each of the five phases
+static void getGerverRate(int phase, const double* state, double* rate)
+{
+    double f = state[0];
+    double k = state[2];
+    double a = state[1] - k;
+    double b = f + state[3];
+    rate[0] = state[1];
+    rate[2] = state[3];
+    switch (phase)
+    {
+        case 0:
+            // The wall facing m pivots, the inner wall holds against the one facing n
+            rate[1] = -1.0 - f;
+            rate[3] = -0.5 - k;
+            break;
+        case 1:
+            // The corner joins and shares the load with the inner wall
+            rate[1] = b - 1.0 - f;
+            rate[3] = 0.5 * (-a - 1.0) - k;
+            break;
+        case 2:
+            // The corner alone holds against both outer walls
+            rate[1] = b - 1.0 - f;
+            rate[3] = -a - 1.0 - k;
+            break;
+        case 3:
+            // The mirror images of the first two phases
+            rate[1] = 0.5 * (b - 1.0) - f;
+            rate[3] = -a - 1.0 - k;
+            break;
+        default:
+            rate[1] = -0.5 - f;
+            rate[3] = -1.0 - k;
+            break;
+    }
+}
+
+// Runge-Kutta steps of the state from time to end within one phase
+static void advanceGerver(int phase, double* state, double time, double end)
+{
+    int steps = (int)ceil((end - time) / 1e-4);
+    double h = (end - time) / steps;
+    for (int s = 0; s < steps; s++)
+    {
+        double k1[4], k2[4], k3[4], k4[4], probe[4];
+        getGerverRate(phase, state, k1);
+        for (int i = 0; i < 4; i++)
+        {
+            probe[i] = state[i] + 0.5 * h * k1[i];
+        }
+        getGerverRate(phase, probe, k2);
+        for (int i = 0; i < 4; i++)
+        {
+            probe[i] = state[i] + 0.5 * h * k2[i];
+        }
+        getGerverRate(phase, probe, k3);
+        for (int i = 0; i < 4; i++)
+        {
+            probe[i] = state[i] + h * k3[i];
+        }
+        getGerverRate(phase, probe, k4);
+        for (int i = 0; i < 4; i++)
+        {
+            state[i] += h / 6.0 * (k1[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]);
+        }
+    }
+}
+
+// Corner at the given ascending times, integrated from x(0) = 0
+static void buildGerverPath(const std::vector<double>& times, std::vector<double>& xs, std::vector<double>& ys)
+{
+    GerverConstants constants = solveGerverConstants();
+    double phase_ends[5] = { constants.phi, constants.theta, M_PI / 2.0 - constants.theta, M_PI / 2.0 - constants.phi, M_PI / 2.0 };
+    // The corner starts at rest along m
+    double start_speed = (constants.A + 0.5) * sin(constants.phi) + (constants.B + 1.0) * cos(constants.phi) - 1.0;
+    double state[4] = { 0.0, 0.0, 0.0, start_speed };
+    int phase = 0;
+    double time = 0.0;
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        while (time < times[i])
+        {
+            // The last phase runs on, times may pass pi / 2 by rounding
+            double end = phase < 4 ? std::min(times[i], phase_ends[phase]) : times[i];
+            advanceGerver(phase, state, time, end);
+            time = end;
+            if (time >= phase_ends[phase] && phase < 4)
+            {
+                phase++;
+            }
+        }
+        xs[i] = state[0] * cos(time) - state[2] * sin(time);
+        ys[i] = state[0] * sin(time) + state[2] * cos(time);
+    }
+}
+
+// Antiderivative of a m + b n at t for a and b quadratic in t - start
+static void integrateRomikPhase(const double* a, const double* b, double start, double t, double& x, double& y)
+{
+    double s = t - start;
+    double along = a[1] + 2.0 * a[2] * s + b[0] + b[1] * s + b[2] * s * s - 2.0 * b[2];
+    double across = 2.0 * a[2] + b[1] + 2.0 * b[2] * s - (a[0] + a[1] * s + a[2] * s * s);
+    x = along * cos(t) - across * sin(t);
+    y = along * sin(t) + across * cos(t);
+}
+
+// Romik solved the contact conditions in closed form. Until phi the corner
+// velocity (a - 1 / 2, b + 1) is (-A - 1 / 2, B + 1) turned by t - phi, after
+// that a falls linearly and b quadratically. Valid up to pi / 4, from x(0) = 0.
+static void getRomikCorner(const GerverConstants& constants, double t, double& x, double& y)
+{
+    double A = constants.A;
+    double B = constants.B;
+    double phi = constants.phi;
+    double theta = constants.theta;
+    auto first = [&](double time, double& px, double& py)
+    {
+        double turn = 2.0 * time - phi;
+        px = 0.5 * sin(time) - cos(time) + 0.5 * (-A - 0.5) * sin(turn) + 0.5 * (B + 1.0) * cos(turn);
+        py = -0.5 * cos(time) - sin(time) - 0.5 * (-A - 0.5) * cos(turn) + 0.5 * (B + 1.0) * sin(turn);
+    };
+    double start_x, start_y, end_x, end_y;
+    first(0.0, start_x, start_y);
+    first(std::min(t, phi), end_x, end_y);
+    x = end_x - start_x;
+    y = end_y - start_y;
+    if (t <= phi)
+    {
+        return;
+    }
+    double second_a[3] = { -A, -1.0, 0.0 };
+    double second_b[3] = { B, -0.5 * (1.0 + A), -0.25 };
+    integrateRomikPhase(second_a, second_b, phi, phi, start_x, start_y);
+    integrateRomikPhase(second_a, second_b, phi, std::min(t, theta), end_x, end_y);
+    x += end_x - start_x;
+    y += end_y - start_y;
+    if (t <= theta)
+    {
+        return;
+    }
+    double span = theta - phi;
+    double third_a[3] = { -A - span, -1.0, 0.0 };
+    double third_b[3] = { B - 0.5 * (1.0 + A) * span - 0.25 * span * span, -1.0, 0.0 };
+    integrateRomikPhase(third_a, third_b, theta, theta, start_x, start_y);
+    integrateRomikPhase(third_a, third_b, theta, t, end_x, end_y);
+    x += end_x - start_x;
+    y += end_y - start_y;
+}
+
+// Past pi / 4 the path is the mirror image of the first half
+static void buildRomikPath(const std::vector<double>& times, std::vector<double>& xs, std::vector<double>& ys)
+{
+    GerverConstants constants = solveGerverConstants();
+    double middle_x, middle_y;
+    getRomikCorner(constants, M_PI / 4.0, middle_x, middle_y);
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        if (times[i] <= M_PI / 4.0)
+        {
+            getRomikCorner(constants, times[i], xs[i], ys[i]);
+        }
+        else
+        {
+            getRomikCorner(constants, M_PI / 2.0 - times[i], xs[i], ys[i]);
+            xs[i] = 2.0 * middle_x - xs[i];
+        }
+    }
+}
+
+void buildSeedMotion(SeedMotion motion, int time_resolution, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence)
+{
+    yaw_sequence.resize(time_resolution);
+    offset_sequence.resize(time_resolution);
+    for (int i = 0; i < time_resolution; i++)
+    {
+        yaw_sequence[i] = time_resolution > 1 ? i * (M_PI / 2.0) / (time_resolution - 1) : 0.0;
+    }
+
+    if (motion == SEED_MOTION_GERVER || motion == SEED_MOTION_ROMIK)
+    {
+        // Gerver's path starts with the corner at the origin. The appended quarter
+        // turn finds the sofa's axis of symmetry to center it like Hammersley's.
+        std::vector<double> times = yaw_sequence;
+        times.push_back(M_PI / 2.0);
+        std::vector<double> xs(times.size());
+        std::vector<double> ys(times.size());
+        if (motion == SEED_MOTION_GERVER)
+        {
+            buildGerverPath(times, xs, ys);
+        }
+        else
+        {
+            buildRomikPath(times, xs, ys);
+        }
+        double center = 0.5 * xs.back();
+        for (int i = 0; i < time_resolution; i++)
+        {
+            offset_sequence[i] = glm::vec3(hallway_width * (xs[i] - center), hallway_width * ys[i], 0.0f);
+        }
+        return;
+    }
+
+    // Hammersley's sofa is two quarter disks joined by a block 4 / pi wide with a
+    // half disk of radius 2 / pi cut from its inner side. While it turns by t its
+    // translation goes around a circle of radius 2 / pi at twice the turning rate,
+    // which keeps the inner corner on the cut out half disk. Without the block it
+    // is the half disk of radius one turning about the corner.
+    double radius = motion == SEED_MOTION_HAMMERSLEY ? 2.0 / M_PI * hallway_width : 0.0;
+    for (int i = 0; i < time_resolution; i++)
+    {
+        double t = yaw_sequence[i];
+        offset_sequence[i] = glm::vec3(radius * cos(2.0 * t), radius * sin(2.0 * t), 0.0f);
+    }
+}
+
+double getSeedMotionArea(SeedMotion motion)
+{
+    switch (motion)
+    {
+        case SEED_MOTION_HALF_DISK:
+            return half_disk_area;
+        case SEED_MOTION_HAMMERSLEY:
+            return hammersley_area;
+        case SEED_MOTION_GERVER:
+        case SEED_MOTION_ROMIK:
+            return gerver_area;
+        default:
+            return 0.0;
+    }
+}
+
+double areaToPixel(double area, int frame_width, int frame_height)
+{
+    return area * hallway_width * hallway_width * frame_width * frame_height / 4.0;
+}
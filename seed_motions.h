@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "libs/glm/glm.hpp"
+
+// Starting motions with known sofas, for runs without motion files and to validate evaluators
+enum SeedMotion
+{
+    SEED_MOTION_FILE,
+    SEED_MOTION_HALF_DISK,
+    SEED_MOTION_HAMMERSLEY,
+    // Gerver's sofa, integrated from the contact conditions of its five phases
+    SEED_MOTION_GERVER,
+    // The same rotation path from Romik's closed form, to check the integration against
+    SEED_MOTION_ROMIK
+};
+
+// The inner walls of hallway.h are this far apart in model space
+const double hallway_width = 0.5;
+
+// Known sofa areas in units of the squared hallway width
+const double half_disk_area = M_PI / 2.0;
+const double hammersley_area = M_PI / 2.0 + 2.0 / M_PI;
+// Gerver's sofa, the best known
+const double gerver_area = 2.21953166887197;
+
+bool parseSeedMotion(const std::string& name, SeedMotion& motion);
+const char* getSeedMotionName(SeedMotion motion);
+
+// Samples the rotation path of the sofa at time_resolution evenly spaced yaws over the quarter turn
+void buildSeedMotion(SeedMotion motion, int time_resolution, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence);
+
+// Area of the seed's sofa, 0 for motions loaded from file
+double getSeedMotionArea(SeedMotion motion);
+
+// Pixels a sofa of this area covers on a frame spanning [-1, 1] in both directions
+double areaToPixel(double area, int frame_width, int frame_height);
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Appends plain values and vectors of plain values to a byte buffer, vectors
+// are prefixed with their element count
+class ByteWriter
+{
+    private:
+    std::vector<char> bytes;
+
+    protected:
+    public:
+    template <typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "ByteWriter only writes plain values");
+        const char* data = reinterpret_cast<const char*>(&value);
+        bytes.insert(bytes.end(), data, data + sizeof(T));
+    }
+
+    template <typename T>
+    void writeVector(const std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "ByteWriter only writes plain values");
+        write<uint64_t>(values.size());
+        const char* data = reinterpret_cast<const char*>(values.data());
+        bytes.insert(bytes.end(), data, data + values.size() * sizeof(T));
+    }
+
+    // Seven bits per byte, small values take one byte
+    void writeVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            bytes.push_back((char)(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back((char)value);
+    }
+
+    // Zigzag maps small negative values to small varints too
+    void writeSignedVarint(int64_t value)
+    {
+        writeVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }
+
+    const std::vector<char>& getBytes()
+    {
+        return bytes;
+    }
+
+    std::vector<char> takeBytes()
+    {
+        return std::move(bytes);
+    }
+};
+
+// Reads back what ByteWriter wrote, every read past the end fails and leaves the reader failed
+class ByteReader
+{
+    private:
+    const char* data;
+    size_t size;
+    size_t position;
+    bool failed;
+
+    protected:
+    public:
+    ByteReader(const std::vector<char>& bytes)
+    : data(bytes.data()), size(bytes.size()), position(0), failed(false)
+    {
+    }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "ByteReader only reads plain values");
+        if (failed || size - position < sizeof(T))
+        {
+            failed = true;
+            return false;
+        }
+        memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+
+    // Vectors longer than max_size are treated as damage
+    template <typename T>
+    bool readVector(std::vector<T>& values, size_t max_size)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "ByteReader only reads plain values");
+        uint64_t count = 0;
+        if (!read(count) || count > max_size || (size - position) / sizeof(T) < count)
+        {
+            failed = true;
+            return false;
+        }
+        values.resize(count);
+        memcpy(values.data(), data + position, count * sizeof(T));
+        position += count * sizeof(T);
+        return true;
+    }
+
+    bool readVarint(uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = 0;
+            if (!read(byte))
+            {
+                return false;
+            }
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        failed = true;
+        return false;
+    }
+
+    bool readSignedVarint(int64_t& value)
+    {
+        uint64_t encoded = 0;
+        if (!readVarint(encoded))
+        {
+            return false;
+        }
+        value = (int64_t)(encoded >> 1) ^ -(int64_t)(encoded & 1);
+        return true;
+    }
+
+    bool hasFailed()
+    {
+        return failed;
+    }
+
+    size_t getRemaining()
+    {
+        return size - position;
+    }
+};
+
+// Lookup table of the reflected polynomial 0xedb88320
+struct Crc32Table
+{
+    uint32_t entries[256];
+
+    Crc32Table()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+// CRC-32 (IEEE 802.3) over a byte range
+inline uint32_t computeCrc32(const char* data, size_t size)
+{
+    static const Crc32Table table;
+
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = table.entries[(crc ^ (uint8_t)data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
@@ -0,0 +1,211 @@
+#include "shader_program.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include "serialize.h"
+#include "shader_sources.h"
+
+static const char shader_cache_magic[8] = { 'S', 'O', 'F', 'A', 'S', 'H', 'D', 'R' };
+static const uint32_t shader_cache_version = 1;
+
+struct ShaderCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t binary_format;
+    uint64_t key;
+    uint32_t length;
+    uint32_t crc;
+};
+
+// FNV-1a over everything the driver output depends on
+static uint64_t hashString(uint64_t hash, const char* text)
+{
+    for (const char* c = text ? text : ""; *c; c++)
+    {
+        hash ^= (uint8_t)*c;
+        hash *= 0x100000001b3ull;
+    }
+    // Separator, so moving characters between strings changes the key
+    hash ^= 0xff;
+    hash *= 0x100000001b3ull;
+    return hash;
+}
+
+static uint64_t computeCacheKey()
+{
+    uint64_t key = 0xcbf29ce484222325ull;
+    key = hashString(key, (const char*)glGetString(GL_VENDOR));
+    key = hashString(key, (const char*)glGetString(GL_RENDERER));
+    key = hashString(key, (const char*)glGetString(GL_VERSION));
+    key = hashString(key, vertex_shader_source);
+    key = hashString(key, fragment_shader_source);
+    return key;
+}
+
+static bool supportsProgramBinary()
+{
+    if (!GLEW_ARB_get_program_binary)
+    {
+        return false;
+    }
+    GLint format_amount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_amount);
+    return format_amount > 0;
+}
+
+static GLuint compileShader(GLenum type, const char* source, const char* name)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        std::cerr << "Failed to compile " << name << ": " << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint linkProgram(bool retrievable)
+{
+    GLuint vertex_shader = compileShader(GL_VERTEX_SHADER, vertex_shader_source, "vertex shader");
+    GLuint fragment_shader = compileShader(GL_FRAGMENT_SHADER, fragment_shader_source, "fragment shader");
+    if (!vertex_shader || !fragment_shader)
+    {
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (retrievable)
+    {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    glDetachShader(program, vertex_shader);
+    glDetachShader(program, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        std::cerr << "Failed to link shader program: " << log << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static GLuint loadCachedProgram(const std::string& cache_filename, uint64_t key)
+{
+    std::ifstream infile(cache_filename, std::ios::binary);
+    if (!infile.is_open())
+    {
+        return 0;
+    }
+
+    ShaderCacheHeader header;
+    if (!infile.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || memcmp(header.magic, shader_cache_magic, sizeof(shader_cache_magic)) != 0
+        || header.version != shader_cache_version || header.key != key)
+    {
+        return 0;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!infile.read(binary.data(), binary.size()) || computeCrc32(binary.data(), binary.size()) != header.crc)
+    {
+        return 0;
+    }
+
+    // The driver may still refuse a binary it wrote, e.g. after an update that kept the version string
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binary_format, binary.data(), (GLsizei)binary.size());
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static void saveCachedProgram(const std::string& cache_filename, uint64_t key, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum binary_format = 0;
+    glGetProgramBinary(program, length, &length, &binary_format, binary.data());
+    binary.resize(length);
+
+    ShaderCacheHeader header;
+    memcpy(header.magic, shader_cache_magic, sizeof(shader_cache_magic));
+    header.version = shader_cache_version;
+    header.binary_format = binary_format;
+    header.key = key;
+    header.length = (uint32_t)binary.size();
+    header.crc = computeCrc32(binary.data(), binary.size());
+
+    // Parallel runs may race on the cache, the rename keeps every reader on a whole file
+    std::string temporary_filename = cache_filename + "." + std::to_string(getpid()) + ".tmp";
+    std::ofstream outfile(temporary_filename, std::ios::binary | std::ios::trunc);
+    if (!outfile.is_open())
+    {
+        std::cerr << "Unable to open shader cache for writing: " << temporary_filename << std::endl;
+        return;
+    }
+    outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outfile.write(binary.data(), binary.size());
+    outfile.close();
+    if (!outfile || rename(temporary_filename.c_str(), cache_filename.c_str()) != 0)
+    {
+        std::cerr << "Unable to write shader cache: " << cache_filename << std::endl;
+        remove(temporary_filename.c_str());
+    }
+}
+
+GLuint buildShaderProgram(const std::string& cache_filename)
+{
+    if (!supportsProgramBinary())
+    {
+        return linkProgram(false);
+    }
+
+    uint64_t key = computeCacheKey();
+    GLuint program = loadCachedProgram(cache_filename, key);
+    if (program)
+    {
+        return program;
+    }
+
+    program = linkProgram(true);
+    if (program)
+    {
+        saveCachedProgram(cache_filename, key, program);
+    }
+    return program;
+}
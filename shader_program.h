@@ -0,0 +1,16 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+// Builds the hallway program from the shader sources embedded at build time
+// (see embed_shaders.sh). When the driver supports program binaries the
+// linked program is stored in cache_filename, keyed by the vendor, renderer
+// and version strings and the sources, and later runs load it from there
+// instead of compiling. A stale or damaged cache is rebuilt. Returns 0 if
+// the shaders do not compile or link.
+GLuint buildShaderProgram(const std::string& cache_filename);
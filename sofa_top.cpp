@@ -0,0 +1,185 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <csignal>
+#include <algorithm>
+
+#include "live_stats.h"
+
+// Copy of the counters at one moment, the rates come from two of them
+struct LiveSnapshot
+{
+    uint64_t nanoseconds;
+    uint64_t evaluations;
+    uint64_t cache_hits;
+    uint64_t improvements;
+    uint64_t busy_nanoseconds;
+};
+
+static uint64_t monotonicNanoseconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static LiveSnapshot takeSnapshot(const LiveStatsBlock* block)
+{
+    LiveSnapshot snapshot;
+    snapshot.nanoseconds = monotonicNanoseconds();
+    snapshot.evaluations = block->evaluations.load(std::memory_order_relaxed);
+    snapshot.cache_hits = block->cache_hits.load(std::memory_order_relaxed);
+    snapshot.improvements = block->improvements.load(std::memory_order_relaxed);
+    snapshot.busy_nanoseconds = block->busy_nanoseconds.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+static std::string formatMicroseconds(double microseconds)
+{
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    if (microseconds < 1e3)
+    {
+        text << microseconds << " us";
+    }
+    else if (microseconds < 1e6)
+    {
+        text << microseconds * 1e-3 << " ms";
+    }
+    else
+    {
+        text << microseconds * 1e-6 << " s";
+    }
+    return text.str();
+}
+
+static std::string formatDuration(uint64_t nanoseconds)
+{
+    uint64_t seconds = nanoseconds / 1000000000ull;
+    std::ostringstream text;
+    text << seconds / 3600 << ":" << std::setw(2) << std::setfill('0') << seconds / 60 % 60 << ":" << std::setw(2) << seconds % 60;
+    return text.str();
+}
+
+// Upper bound of the bucket that holds the given fraction of the samples
+static double histogramQuantile(const std::atomic<uint64_t>* histogram, uint64_t total, double fraction)
+{
+    uint64_t target = (uint64_t)(fraction * total);
+    uint64_t seen = 0;
+    for (int b = 0; b < live_histogram_buckets; b++)
+    {
+        seen += histogram[b].load(std::memory_order_relaxed);
+        if (seen > target)
+        {
+            return (double)(2ull << b);
+        }
+    }
+    return (double)(2ull << (live_histogram_buckets - 1));
+}
+
+static void display(const LiveStatsBlock* block, const LiveSnapshot& previous, const LiveSnapshot& current, bool clear)
+{
+    double seconds = (current.nanoseconds - previous.nanoseconds) * 1e-9;
+    uint64_t evaluations = current.evaluations - previous.evaluations;
+    uint64_t workers = std::max<uint64_t>(block->worker_amount.load(std::memory_order_relaxed), 1);
+    double evaluations_per_second = seconds > 0.0 ? evaluations / seconds : 0.0;
+    double utilization = seconds > 0.0 ? (current.busy_nanoseconds - previous.busy_nanoseconds) * 1e-9 / (seconds * workers) : 0.0;
+    double recent_improvement_rate = evaluations > 0 ? (double)(current.improvements - previous.improvements) / evaluations : 0.0;
+    double improvement_rate = current.evaluations > 0 ? (double)current.improvements / current.evaluations : 0.0;
+    double cache_hit_rate = current.evaluations > 0 ? (double)current.cache_hits / current.evaluations : 0.0;
+
+    bool alive = kill((pid_t)block->pid, 0) == 0;
+    uint64_t updated = block->updated_nanoseconds.load(std::memory_order_relaxed);
+    uint64_t quiet = current.nanoseconds > updated ? current.nanoseconds - updated : 0;
+
+    if (clear)
+    {
+        std::cout << "\033[H\033[2J";
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "sofa pid " << block->pid << (alive ? "" : " (exited)") << "  running " << formatDuration(current.nanoseconds - block->start_nanoseconds)
+        << "  last update " << quiet * 1e-9 << " s ago" << std::endl;
+    std::cout << "generation   " << block->generation.load(std::memory_order_relaxed)
+        << "  best score " << block->best_score.load(std::memory_order_relaxed) << std::endl;
+    std::cout << "evaluations  " << current.evaluations << "  " << evaluations_per_second << "/s  cache hits " << cache_hit_rate * 100.0 << "%" << std::endl;
+    std::cout << "improvements " << current.improvements << "  " << improvement_rate * 100.0 << "% of evaluations, "
+        << recent_improvement_rate * 100.0 << "% recently" << std::endl;
+    std::cout << "utilization  " << utilization * 100.0 << "% of " << workers << " workers" << std::endl;
+    std::cout << std::endl;
+    std::cout << std::left << std::setw(10) << "phase" << std::right << std::setw(12) << "count" << std::setw(12) << "p50 <=" << std::setw(12) << "p90 <="
+        << std::setw(12) << "p99 <=" << std::endl;
+    for (int p = 0; p < LIVE_PHASE_AMOUNT; p++)
+    {
+        const std::atomic<uint64_t>* histogram = block->histograms[p];
+        uint64_t total = 0;
+        for (int b = 0; b < live_histogram_buckets; b++)
+        {
+            total += histogram[b].load(std::memory_order_relaxed);
+        }
+        std::cout << std::left << std::setw(10) << getLivePhaseName((LivePhase)p) << std::right << std::setw(12) << total;
+        if (total > 0)
+        {
+            std::cout << std::setw(12) << formatMicroseconds(histogramQuantile(histogram, total, 0.5))
+                << std::setw(12) << formatMicroseconds(histogramQuantile(histogram, total, 0.9))
+                << std::setw(12) << formatMicroseconds(histogramQuantile(histogram, total, 0.99));
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Shows the live statistics of a running sofa, attached read-only so the run does not notice
+int main(int argc, char* argv[])
+{
+    std::string name = "/sofa-stats";
+    double interval = 1.0;
+    bool once = false;
+    for (int a = 1; a < argc; a++)
+    {
+        std::string argument = argv[a];
+        if (argument == "--name" && a + 1 < argc)
+        {
+            name = argv[++a];
+        }
+        else if (argument == "--interval" && a + 1 < argc)
+        {
+            interval = std::max(atof(argv[++a]), 0.1);
+        }
+        else if (argument == "--once")
+        {
+            once = true;
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--name /sofa-stats] [--interval 1.0] [--once]" << std::endl;
+            return -1;
+        }
+    }
+
+    const LiveStatsBlock* block = attachLiveStats(name);
+    if (!block)
+    {
+        return -1;
+    }
+
+    // Rates of a single display are taken since the start of the run
+    LiveSnapshot previous = { block->start_nanoseconds, 0, 0, 0, 0 };
+    while (true)
+    {
+        LiveSnapshot current = takeSnapshot(block);
+        display(block, previous, current, !once);
+        if (once || kill((pid_t)block->pid, 0) != 0)
+        {
+            break;
+        }
+        previous = current;
+        std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+    }
+
+    detachLiveStats(block);
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "soft_rasterizer.h"
+
+// Sigmoid arguments beyond this are treated as exactly 0 or 1
+static const double sigmoid_cutoff = 30.0;
+// Pixels whose remaining product drops below this are considered dead
+static const double dead_threshold = 1e-12;
+
+// Soft coverage of a wall at the local point (px, py), the four edge sigmoids are written to edge
+static inline double wallCoverage(const WallRect& wall, double px, double py, double slope, double* edge)
+{
+    double z[4] =
+    {
+        slope * (px - wall.min_x),
+        slope * (wall.max_x - px),
+        slope * (py - wall.min_y),
+        slope * (wall.max_y - py)
+    };
+
+    double coverage = 1.0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (z[i] < -sigmoid_cutoff)
+        {
+            return 0.0;
+        }
+        edge[i] = z[i] > sigmoid_cutoff ? 1.0 : 1.0 / (1.0 + exp(-z[i]));
+        coverage *= edge[i];
+    }
+    return coverage;
+}
+
+SoftRasterizer::SoftRasterizer(int frame_width, int frame_height, int thread_amount)
+: FRAME_WIDTH(frame_width), FRAME_HEIGHT(frame_height), thread_amount(thread_amount), tile_size(32), sharpness(1.0)
+{
+    if (this->thread_amount <= 0)
+    {
+        this->thread_amount = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+}
+
+void SoftRasterizer::setSharpness(double sharpness)
+{
+    this->sharpness = sharpness;
+}
+
+double SoftRasterizer::getSharpness()
+{
+    return sharpness;
+}
+
+void SoftRasterizer::annealSharpness(double factor, double max_sharpness)
+{
+    sharpness = std::min(sharpness * factor, max_sharpness);
+}
+
+double SoftRasterizer::Render(int time_resolution, glm::vec3 anchor, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence)
+{
+    std::vector<double> gradient;
+    return renderPass(time_resolution, anchor, yaw_sequence, offset_sequence, false, gradient);
+}
+
+double SoftRasterizer::Render(int time_resolution, glm::vec3 anchor, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence, std::vector<double>& yaw_gradient, std::vector<glm::vec3>& offset_gradient)
+{
+    std::vector<double> gradient;
+    double area = renderPass(time_resolution, anchor, yaw_sequence, offset_sequence, true, gradient);
+
+    yaw_gradient.resize(time_resolution);
+    offset_gradient.resize(time_resolution);
+    for (int i = 0; i < time_resolution; i++)
+    {
+        yaw_gradient[i] = gradient[i];
+        offset_gradient[i] = glm::vec3((float)gradient[time_resolution + i], (float)gradient[2 * time_resolution + i], 0.0f);
+    }
+
+    return area;
+}
+
+double SoftRasterizer::renderPass(int time_resolution, glm::vec3 anchor, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence, bool with_gradient, std::vector<double>& gradient)
+{
+    std::vector<double> cos_yaw(time_resolution);
+    std::vector<double> sin_yaw(time_resolution);
+    for (int i = 0; i < time_resolution; i++)
+    {
+        cos_yaw[i] = cos(yaw_sequence[i]);
+        sin_yaw[i] = sin(yaw_sequence[i]);
+    }
+
+    // Yaw, offset x and offset y gradients are packed one after another
+    int gradient_size = with_gradient ? 3 * time_resolution : 0;
+    std::vector<double> thread_areas(thread_amount, 0.0);
+    std::vector<std::vector<double>> thread_gradients(thread_amount, std::vector<double>(gradient_size, 0.0));
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < thread_amount; t++)
+    {
+        threads.push_back(std::thread(&SoftRasterizer::renderTiles, this, t, time_resolution, anchor, std::cref(cos_yaw), std::cref(sin_yaw), std::cref(offset_sequence), with_gradient, std::ref(thread_areas[t]), std::ref(thread_gradients[t])));
+    }
+    renderTiles(0, time_resolution, anchor, cos_yaw, sin_yaw, offset_sequence, with_gradient, thread_areas[0], thread_gradients[0]);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Reduce in thread order so the result only depends on the thread amount
+    double area = 0.0;
+    gradient.assign(gradient_size, 0.0);
+    for (int t = 0; t < thread_amount; t++)
+    {
+        area += thread_areas[t];
+        for (int i = 0; i < gradient_size; i++)
+        {
+            gradient[i] += thread_gradients[t][i];
+        }
+    }
+
+    return area;
+}
+
+void SoftRasterizer::renderTiles(int thread_id, int time_resolution, glm::vec3 anchor, const std::vector<double>& cos_yaw, const std::vector<double>& sin_yaw, const std::vector<glm::vec3>& offset_sequence, bool with_gradient, double& area, std::vector<double>& gradient)
+{
+    // Sigmoid slope in normalized device coordinates
+    double slope = sharpness * std::min(FRAME_WIDTH, FRAME_HEIGHT) / 2.0;
+
+    int tiles_x = (FRAME_WIDTH + tile_size - 1) / tile_size;
+    int tiles_y = (FRAME_HEIGHT + tile_size - 1) / tile_size;
+    int tile_amount = tiles_x * tiles_y;
+
+    double* yaw_gradient = gradient.data();
+    double* x_gradient = gradient.data() + time_resolution;
+    double* y_gradient = gradient.data() + 2 * time_resolution;
+
+    double edge[4];
+
+    for (int tile = thread_id; tile < tile_amount; tile += thread_amount)
+    {
+        int begin_x = (tile % tiles_x) * tile_size;
+        int begin_y = (tile / tiles_x) * tile_size;
+        int end_x = std::min(begin_x + tile_size, FRAME_WIDTH);
+        int end_y = std::min(begin_y + tile_size, FRAME_HEIGHT);
+
+        for (int row = begin_y; row < end_y; row++)
+        {
+            double qy = (row + 0.5) * 2.0 / FRAME_HEIGHT - 1.0;
+            for (int col = begin_x; col < end_x; col++)
+            {
+                double qx = (col + 0.5) * 2.0 / FRAME_WIDTH - 1.0;
+
+                // Forward pass, product of (1 - coverage) over every wall of every frame
+                double remaining = 1.0;
+                for (int i = 0; i < time_resolution && remaining > 0.0; i++)
+                {
+                    double dx = qx - offset_sequence[i].x - anchor.x;
+                    double dy = qy - offset_sequence[i].y - anchor.y;
+                    double px = cos_yaw[i] * dx + sin_yaw[i] * dy + anchor.x;
+                    double py = -sin_yaw[i] * dx + cos_yaw[i] * dy + anchor.y;
+
+                    for (int w = 0; w < hallway_wall_amount; w++)
+                    {
+                        double coverage = wallCoverage(hallway_walls[w], px, py, slope, edge);
+                        remaining *= 1.0 - coverage;
+                    }
+                    if (remaining < dead_threshold)
+                    {
+                        remaining = 0.0;
+                    }
+                }
+
+                area += remaining;
+
+                if (!with_gradient || remaining == 0.0)
+                {
+                    continue;
+                }
+
+                // Backward pass, d(remaining)/d(coverage) = -remaining / (1 - coverage)
+                for (int i = 0; i < time_resolution; i++)
+                {
+                    double dx = qx - offset_sequence[i].x - anchor.x;
+                    double dy = qy - offset_sequence[i].y - anchor.y;
+                    double px = cos_yaw[i] * dx + sin_yaw[i] * dy + anchor.x;
+                    double py = -sin_yaw[i] * dx + cos_yaw[i] * dy + anchor.y;
+
+                    for (int w = 0; w < hallway_wall_amount; w++)
+                    {
+                        double coverage = wallCoverage(hallway_walls[w], px, py, slope, edge);
+                        if (coverage == 0.0)
+                        {
+                            continue;
+                        }
+
+                        double weight = -remaining / (1.0 - coverage);
+                        double d_px = weight * coverage * slope * (edge[1] - edge[0]);
+                        double d_py = weight * coverage * slope * (edge[3] - edge[2]);
+
+                        yaw_gradient[i] += d_px * (py - anchor.y) - d_py * (px - anchor.x);
+                        x_gradient[i] += -d_px * cos_yaw[i] + d_py * sin_yaw[i];
+                        y_gradient[i] += -d_px * sin_yaw[i] - d_py * cos_yaw[i];
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <thread>
+
+#include "libs/glm/glm.hpp"
+
+#include "hallway.h"
+
+// Smooth alternative to Renderer::Render. Every transformed wall covers a pixel
+// with the product of sigmoids of its signed edge distances, and the soft area
+// is the sum over all pixels of the product over all walls of (1 - coverage).
+// The gradient with respect to every yaw and offset sample is computed in one
+// backward pass over the same pixel tiles.
+class SoftRasterizer
+{
+    private:
+    const int FRAME_WIDTH;
+    const int FRAME_HEIGHT;
+
+    int thread_amount;
+    int tile_size;
+
+    // Inverse edge width in pixels, larger is closer to the hard rasterizer
+    double sharpness;
+
+    double renderPass(int time_resolution, glm::vec3 anchor, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence, bool with_gradient, std::vector<double>& gradient);
+    void renderTiles(int thread_id, int time_resolution, glm::vec3 anchor, const std::vector<double>& cos_yaw, const std::vector<double>& sin_yaw, const std::vector<glm::vec3>& offset_sequence, bool with_gradient, double& area, std::vector<double>& gradient);
+
+    protected:
+    public:
+    SoftRasterizer(int frame_width, int frame_height, int thread_amount);
+    void setSharpness(double sharpness);
+    double getSharpness();
+    void annealSharpness(double factor, double max_sharpness);
+    double Render(int time_resolution, glm::vec3 anchor, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence);
+    double Render(int time_resolution, glm::vec3 anchor, const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence, std::vector<double>& yaw_gradient, std::vector<glm::vec3>& offset_gradient);
+};
@@ -0,0 +1,136 @@
+#include "spline_basis.h"
+
+SplineBasis::SplineBasis(int control_amount, int time_resolution)
+: control_amount(std::max(control_amount, 4)), time_resolution(time_resolution)
+{
+    int segment_amount = this->control_amount - 3;
+
+    for (int k = 0; k < 4; k++)
+    {
+        weights[k].resize(time_resolution);
+    }
+    segment_begin.assign(segment_amount + 1, time_resolution);
+    segment_begin[0] = 0;
+
+    int segment = 0;
+    for (int i = 0; i < time_resolution; i++)
+    {
+        double u = time_resolution > 1 ? (double)i * segment_amount / (time_resolution - 1) : 0.0;
+        int s = std::min((int)u, segment_amount - 1);
+        while (segment < s)
+        {
+            segment++;
+            segment_begin[segment] = i;
+        }
+
+        double t = u - s;
+        double t2 = t * t;
+        double t3 = t2 * t;
+        weights[0][i] = (1.0 - t) * (1.0 - t) * (1.0 - t) / 6.0;
+        weights[1][i] = (3.0 * t3 - 6.0 * t2 + 4.0) / 6.0;
+        weights[2][i] = (-3.0 * t3 + 3.0 * t2 + 3.0 * t + 1.0) / 6.0;
+        weights[3][i] = t3 / 6.0;
+    }
+}
+
+int SplineBasis::getControlAmount()
+{
+    return control_amount;
+}
+
+int SplineBasis::getTimeResolution()
+{
+    return time_resolution;
+}
+
+void SplineBasis::evaluate(const SplineMotion& motion, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence)
+{
+    yaw_sequence.resize(time_resolution);
+    offset_sequence.resize(time_resolution);
+
+    const double* w0 = weights[0].data();
+    const double* w1 = weights[1].data();
+    const double* w2 = weights[2].data();
+    const double* w3 = weights[3].data();
+    double* yaw = yaw_sequence.data();
+
+    for (int s = 0; s + 1 < (int)segment_begin.size(); s++)
+    {
+        int begin = segment_begin[s];
+        int end = segment_begin[s + 1];
+
+        double c0 = motion.yaw_controls[s];
+        double c1 = motion.yaw_controls[s + 1];
+        double c2 = motion.yaw_controls[s + 2];
+        double c3 = motion.yaw_controls[s + 3];
+        for (int i = begin; i < end; i++)
+        {
+            yaw[i] = w0[i] * c0 + w1[i] * c1 + w2[i] * c2 + w3[i] * c3;
+        }
+
+        glm::vec3 o0 = motion.offset_controls[s];
+        glm::vec3 o1 = motion.offset_controls[s + 1];
+        glm::vec3 o2 = motion.offset_controls[s + 2];
+        glm::vec3 o3 = motion.offset_controls[s + 3];
+        for (int i = begin; i < end; i++)
+        {
+            double x = w0[i] * o0.x + w1[i] * o1.x + w2[i] * o2.x + w3[i] * o3.x;
+            double y = w0[i] * o0.y + w1[i] * o1.y + w2[i] * o2.y + w3[i] * o3.y;
+            offset_sequence[i] = glm::vec3((float)x, (float)y, 0.0f);
+        }
+    }
+}
+
+SplineMotion SplineBasis::fit(const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence)
+{
+    int n = control_amount;
+    int frame_amount = std::min(time_resolution, (int)std::min(yaw_sequence.size(), offset_sequence.size()));
+
+    // Least squares normal equations, a tiny ridge keeps short sequences solvable
+    std::vector<double> normal(n * n, 0.0);
+    std::vector<double> yaw_rhs(n, 0.0);
+    std::vector<double> x_rhs(n, 0.0);
+    std::vector<double> y_rhs(n, 0.0);
+
+    for (int s = 0; s + 1 < (int)segment_begin.size(); s++)
+    {
+        for (int i = segment_begin[s]; i < std::min(segment_begin[s + 1], frame_amount); i++)
+        {
+            for (int a = 0; a < 4; a++)
+            {
+                for (int b = 0; b < 4; b++)
+                {
+                    normal[(s + a) * n + s + b] += weights[a][i] * weights[b][i];
+                }
+                yaw_rhs[s + a] += weights[a][i] * yaw_sequence[i];
+                x_rhs[s + a] += weights[a][i] * offset_sequence[i].x;
+                y_rhs[s + a] += weights[a][i] * offset_sequence[i].y;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++)
+    {
+        normal[i * n + i] += 1e-9;
+    }
+
+    SplineMotion motion;
+    motion.yaw_controls = solveLinearSystem(normal, yaw_rhs, n);
+    std::vector<double> x_controls = solveLinearSystem(normal, x_rhs, n);
+    std::vector<double> y_controls = solveLinearSystem(normal, y_rhs, n);
+
+    if (motion.yaw_controls.empty() || x_controls.empty() || y_controls.empty())
+    {
+        std::cerr << "Failed to fit spline motion." << std::endl;
+        motion.yaw_controls.assign(n, 0.0);
+        motion.offset_controls.assign(n, glm::vec3(0.0f));
+        return motion;
+    }
+
+    motion.offset_controls.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        motion.offset_controls[i] = glm::vec3((float)x_controls[i], (float)y_controls[i], 0.0f);
+    }
+
+    return motion;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "libs/glm/glm.hpp"
+
+#include "util.h"
+
+// Motion described by the control points of uniform cubic B-splines
+// for the yaw and the offset, the z component of the offsets stays zero
+struct SplineMotion
+{
+    std::vector<double> yaw_controls;
+    std::vector<glm::vec3> offset_controls;
+};
+
+// Precomputed cubic B-spline weights that map control points to per-frame samples.
+// The frames of one segment share their four control points, so evaluation is a
+// contiguous multiply-add over every segment that the compiler vectorizes.
+class SplineBasis
+{
+    private:
+    int control_amount;
+    int time_resolution;
+
+    // First frame of every segment, segment_amount + 1 entries
+    std::vector<int> segment_begin;
+    std::vector<double> weights[4];
+
+    protected:
+    public:
+    SplineBasis(int control_amount, int time_resolution);
+    int getControlAmount();
+    int getTimeResolution();
+    void evaluate(const SplineMotion& motion, std::vector<double>& yaw_sequence, std::vector<glm::vec3>& offset_sequence);
+    SplineMotion fit(const std::vector<double>& yaw_sequence, const std::vector<glm::vec3>& offset_sequence);
+};
@@ -0,0 +1,125 @@
+#include "steady_state.h"
+
+SteadyStateRunner::SteadyStateRunner(Optimizer& optimizer, FitnessCache* fitness_cache, int worker_amount, int frame_width, int frame_height, int time_resolution, glm::vec3 anchor)
+: optimizer(optimizer), fitness_cache(fitness_cache), pool(worker_amount, frame_width, frame_height, time_resolution, anchor), live_stats(nullptr), busy_seconds(0.0), elapsed_seconds(0.0)
+{
+
+}
+
+void SteadyStateRunner::run(int evaluation_budget)
+{
+    busy_seconds = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    pool.start();
+
+    // Two candidates per worker keep every worker busy while the optimizer catches up
+    int max_in_flight = 2 * pool.getWorkerAmount();
+    std::unordered_map<int, Individual> in_flight;
+    std::unordered_map<int, Hash128> in_flight_hashes;
+    int dispatched = 0;
+    int completed = 0;
+    int next_id = 0;
+
+    while (completed < evaluation_budget)
+    {
+        while ((int)in_flight.size() < max_in_flight && dispatched < evaluation_budget)
+        {
+            auto spawn_start = std::chrono::steady_clock::now();
+            Individual candidate = optimizer.spawnCandidate();
+            dispatched++;
+            if (live_stats)
+            {
+                live_stats->recordPhase(LIVE_PHASE_BREED, std::chrono::duration<double>(std::chrono::steady_clock::now() - spawn_start).count());
+            }
+
+            int cached_score;
+            Hash128 candidate_hash;
+            if (fitness_cache)
+            {
+                candidate_hash = fitness_cache->hashCandidate(candidate.yaw_sequence, candidate.offset_sequence);
+                if (fitness_cache->lookup(candidate_hash, cached_score))
+                {
+                    bool improved = optimizer.submitCandidate(candidate, cached_score);
+                    completed++;
+                    if (live_stats)
+                    {
+                        live_stats->recordEvaluation(optimizer.getBestScore(), improved, true, 0.0);
+                    }
+                    continue;
+                }
+            }
+
+            EvaluationTask task = { next_id, candidate.yaw_sequence, candidate.offset_sequence };
+            in_flight[next_id] = candidate;
+            if (fitness_cache)
+            {
+                in_flight_hashes[next_id] = candidate_hash;
+            }
+            next_id++;
+
+            pool.submit(task);
+        }
+
+        // The last candidates may all have been cache hits, then nothing is in flight
+        if (completed >= evaluation_budget)
+        {
+            break;
+        }
+        EvaluationResult result;
+        pool.waitForResult(result);
+
+        Individual candidate = in_flight[result.id];
+        in_flight.erase(result.id);
+        if (fitness_cache)
+        {
+            fitness_cache->insert(in_flight_hashes[result.id], result.score);
+            in_flight_hashes.erase(result.id);
+        }
+
+        busy_seconds += result.seconds;
+        completed++;
+        auto submit_start = std::chrono::steady_clock::now();
+        bool improved = optimizer.submitCandidate(candidate, result.score, result.seconds);
+        if (live_stats)
+        {
+            live_stats->recordPhase(LIVE_PHASE_SELECT, std::chrono::duration<double>(std::chrono::steady_clock::now() - submit_start).count());
+            live_stats->recordPhase(LIVE_PHASE_EVALUATE, result.seconds);
+            live_stats->recordEvaluation(optimizer.getBestScore(), improved, false, result.seconds);
+        }
+        if (improved)
+        {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Evaluation " << completed << " Pixel " << result.score << " after " << seconds << " s" << std::endl;
+        }
+    }
+
+    pool.stop();
+
+    elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double SteadyStateRunner::getUtilization()
+{
+    if (elapsed_seconds <= 0.0)
+    {
+        return 0.0;
+    }
+
+    return busy_seconds / (pool.getWorkerAmount() * elapsed_seconds);
+}
+
+double SteadyStateRunner::getElapsedSeconds()
+{
+    return elapsed_seconds;
+}
+
+void SteadyStateRunner::setTelemetry(TelemetryLogger* telemetry)
+{
+    pool.setTelemetry(telemetry);
+}
+
+void SteadyStateRunner::setLiveStats(LiveStats* live_stats)
+{
+    this->live_stats = live_stats;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <unordered_map>
+
+#include "libs/glm/glm.hpp"
+
+#include "optimizer.h"
+#include "fitness_cache.h"
+#include "evaluator_pool.h"
+#include "live_stats.h"
+
+// Steady-state evolution without generation barriers. The workers of an EvaluatorPool
+// take candidates as soon as they are free. The calling thread owns the optimizer,
+// submits every score the moment it arrives and immediately spawns a replacement.
+class SteadyStateRunner
+{
+    private:
+    Optimizer& optimizer;
+    FitnessCache* fitness_cache;
+
+    EvaluatorPool pool;
+    LiveStats* live_stats;
+
+    double busy_seconds;
+    double elapsed_seconds;
+
+    protected:
+    public:
+    SteadyStateRunner(Optimizer& optimizer, FitnessCache* fitness_cache, int worker_amount, int frame_width, int frame_height, int time_resolution, glm::vec3 anchor);
+    void run(int evaluation_budget);
+    // Fraction of the elapsed time the workers spent evaluating
+    double getUtilization();
+    double getElapsedSeconds();
+    void setTelemetry(TelemetryLogger* telemetry);
+    void setLiveStats(LiveStats* live_stats);
+};
@@ -0,0 +1,99 @@
+#include "surrogate.h"
+
+Surrogate::Surrogate(int feature_amount, double ridge, double decay)
+: feature_amount(feature_amount), ridge(ridge), decay(decay), weights_dirty(false), sample_amount(0)
+{
+    gram.assign(feature_amount * feature_amount, 0.0);
+    moment.assign(feature_amount, 0.0);
+    weights.assign(feature_amount, 0.0);
+}
+
+void Surrogate::train(const std::vector<double>& features, double target)
+{
+    for (int i = 0; i < feature_amount; i++)
+    {
+        moment[i] = decay * moment[i] + features[i] * target;
+        for (int j = 0; j < feature_amount; j++)
+        {
+            gram[i * feature_amount + j] = decay * gram[i * feature_amount + j] + features[i] * features[j];
+        }
+    }
+    sample_amount++;
+    weights_dirty = true;
+}
+
+void Surrogate::solve()
+{
+    std::vector<double> regularized = gram;
+    for (int i = 0; i < feature_amount; i++)
+    {
+        regularized[i * feature_amount + i] += ridge;
+    }
+
+    std::vector<double> solution = solveLinearSystem(regularized, moment, feature_amount);
+    if (!solution.empty())
+    {
+        weights = solution;
+    }
+    weights_dirty = false;
+}
+
+double Surrogate::predict(const std::vector<double>& features)
+{
+    if (weights_dirty)
+    {
+        solve();
+    }
+
+    double prediction = 0.0;
+    for (int i = 0; i < feature_amount; i++)
+    {
+        prediction += weights[i] * features[i];
+    }
+    return prediction;
+}
+
+int Surrogate::getSampleAmount()
+{
+    return sample_amount;
+}
+
+bool Surrogate::isReady()
+{
+    return sample_amount >= 2 * feature_amount;
+}
+
+void Surrogate::saveState(ByteWriter& writer)
+{
+    writer.write<int32_t>(sample_amount);
+    writer.write<uint8_t>(weights_dirty);
+    writer.writeVector(gram);
+    writer.writeVector(moment);
+    writer.writeVector(weights);
+}
+
+bool Surrogate::loadState(ByteReader& reader)
+{
+    int32_t samples = 0;
+    uint8_t dirty = 0;
+    std::vector<double> new_gram;
+    std::vector<double> new_moment;
+    std::vector<double> new_weights;
+    reader.read(samples);
+    reader.read(dirty);
+    reader.readVector(new_gram, feature_amount * feature_amount);
+    reader.readVector(new_moment, feature_amount);
+    reader.readVector(new_weights, feature_amount);
+    if (reader.hasFailed() || (int)new_gram.size() != feature_amount * feature_amount || (int)new_moment.size() != feature_amount || (int)new_weights.size() != feature_amount)
+    {
+        std::cerr << "Surrogate state does not match " << feature_amount << " features" << std::endl;
+        return false;
+    }
+
+    sample_amount = samples;
+    weights_dirty = dirty != 0;
+    gram = new_gram;
+    moment = new_moment;
+    weights = new_weights;
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "util.h"
+#include "serialize.h"
+
+// Online ridge regression that predicts the score change of a child from a short
+// feature vector describing how it was made (bump means, widths, amplitudes).
+// Sufficient statistics decay exponentially so the model follows the search.
+class Surrogate
+{
+    private:
+    int feature_amount;
+    double ridge;
+    double decay;
+
+    std::vector<double> gram;
+    std::vector<double> moment;
+    std::vector<double> weights;
+    bool weights_dirty;
+    int sample_amount;
+
+    void solve();
+
+    protected:
+    public:
+    Surrogate(int feature_amount, double ridge, double decay);
+    void train(const std::vector<double>& features, double target);
+    double predict(const std::vector<double>& features);
+    int getSampleAmount();
+    // Enough samples to rank candidates better than chance
+    bool isReady();
+    // Sufficient statistics and weights, so a resumed run predicts exactly like the original
+    void saveState(ByteWriter& writer);
+    bool loadState(ByteReader& reader);
+};
+
+// Per generation record of how well the surrogate ranked and how many renders it saved
+struct SurrogateStats
+{
+    int generation;
+    int screened;
+    int evaluated;
+    double correlation;
+    double mean_absolute_error;
+};
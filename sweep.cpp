@@ -0,0 +1,279 @@
+#include "sweep.h"
+
+static bool setSweepField(SweepConfig& config, const std::string& key, double value)
+{
+    if (key == "population_amount") config.population_amount = std::max((int)std::lround(value), 1);
+    else if (key == "surviver_amount") config.surviver_amount = std::max((int)std::lround(value), 1);
+    else if (key == "generations") config.generations = std::max((int)std::lround(value), 1);
+    else if (key == "basis_size") config.basis_size = std::max((int)std::lround(value), 0);
+    else if (key == "step_size_regions") config.step_size_regions = std::max((int)std::lround(value), 0);
+    else if (key == "surrogate_oversampling") config.surrogate_oversampling = std::max((int)std::lround(value), 1);
+    else if (key == "selection_mode") config.selection_mode = value >= 0.5 ? SELECTION_COMMA : SELECTION_PLUS;
+    else if (key == "amplitude_scale") config.amplitude_scale = value;
+    else if (key == "recombination_rate") config.recombination_rate = value;
+    else if (key == "seed") config.seed = (uint64_t)std::llround(value);
+    else return false;
+    return true;
+}
+
+// Splits "key=a,b,c" into the key and its values, or "key=lo:hi" into the key and a range
+static bool parseSweepTerm(const std::string& term, std::string& key, std::vector<double>& values, bool& is_range)
+{
+    size_t equals = term.find('=');
+    if (equals == std::string::npos)
+    {
+        return false;
+    }
+    key = term.substr(0, equals);
+    std::string list = term.substr(equals + 1);
+
+    is_range = list.find(':') != std::string::npos;
+    std::replace(list.begin(), list.end(), ',', ' ');
+    std::replace(list.begin(), list.end(), ':', ' ');
+
+    values.clear();
+    std::istringstream stream(list);
+    double value;
+    while (stream >> value)
+    {
+        values.push_back(value);
+    }
+    return !values.empty() && (!is_range || values.size() == 2) && stream.eof();
+}
+
+bool loadSweepConfigs(const std::string& filename, const SweepConfig& defaults, std::vector<SweepConfig>& configs)
+{
+    std::ifstream infile(filename);
+    if (!infile.is_open())
+    {
+        std::cerr << "Unable to open sweep file: " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(infile, line))
+    {
+        line_number++;
+        std::istringstream words(line);
+        std::string first;
+        if (!(words >> first) || first[0] == '#')
+        {
+            continue;
+        }
+
+        bool random = first == "random";
+        int sample_amount = 0;
+        if (random && !(words >> sample_amount))
+        {
+            std::cerr << "Sweep file line " << line_number << ": random needs a sample amount" << std::endl;
+            return false;
+        }
+
+        std::vector<std::string> terms;
+        if (first != "grid" && !random)
+        {
+            terms.push_back(first);
+        }
+        std::string term;
+        while (words >> term)
+        {
+            terms.push_back(term);
+        }
+
+        std::vector<std::string> keys;
+        std::vector<std::vector<double>> values;
+        std::vector<bool> ranges;
+        for (const std::string& text : terms)
+        {
+            std::string key;
+            std::vector<double> term_values;
+            bool is_range = false;
+            SweepConfig probe = defaults;
+            if (!parseSweepTerm(text, key, term_values, is_range) || (is_range && !random) || !setSweepField(probe, key, term_values[0]))
+            {
+                std::cerr << "Sweep file line " << line_number << ": cannot use " << text << std::endl;
+                return false;
+            }
+            keys.push_back(key);
+            values.push_back(term_values);
+            ranges.push_back(is_range);
+        }
+
+        if (random)
+        {
+            // Every line draws from its own stream, so editing one line leaves the others unchanged
+            for (int s = 0; s < sample_amount; s++)
+            {
+                RngStream stream(defaults.seed, line_number, s, RNG_PURPOSE_SELECTION);
+                SweepConfig config = defaults;
+                for (size_t k = 0; k < keys.size(); k++)
+                {
+                    // Ranges are sampled uniformly, lists pick one of their values
+                    double value = ranges[k] ? stream.nextUniform(values[k][0], values[k][1]) : values[k][stream.nextUInt() % values[k].size()];
+                    setSweepField(config, keys[k], value);
+                }
+                configs.push_back(config);
+            }
+            continue;
+        }
+
+        // Odometer over the value lists, the last key changes fastest
+        std::vector<size_t> digits(keys.size(), 0);
+        while (true)
+        {
+            SweepConfig config = defaults;
+            for (size_t k = 0; k < keys.size(); k++)
+            {
+                setSweepField(config, keys[k], values[k][digits[k]]);
+            }
+            configs.push_back(config);
+
+            int k = (int)keys.size() - 1;
+            while (k >= 0 && ++digits[k] == values[k].size())
+            {
+                digits[k] = 0;
+                k--;
+            }
+            if (k < 0)
+            {
+                break;
+            }
+        }
+    }
+
+    std::cout << "Loaded " << configs.size() << " sweep configurations from " << filename << std::endl;
+    return !configs.empty();
+}
+
+SweepRunner::SweepRunner(const std::vector<SweepConfig>& configs, const std::vector<double>& root_yaw_sequence, const std::vector<glm::vec3>& root_offset_sequence,
+    int worker_amount, int frame_width, int frame_height, int time_resolution, glm::vec3 anchor)
+: pool(worker_amount, frame_width, frame_height, time_resolution, anchor)
+{
+    for (const SweepConfig& config : configs)
+    {
+        SweepRun run;
+        run.config = config;
+        run.optimizer.reset(new Optimizer(time_resolution, root_yaw_sequence, root_offset_sequence, config.population_amount, config.surviver_amount, config.basis_size, config.seed));
+        run.optimizer->setSelectionMode((SelectionMode)config.selection_mode);
+        run.optimizer->setRecombinationRate(config.recombination_rate);
+        run.optimizer->setSurrogateOversampling(config.surrogate_oversampling);
+        run.optimizer->setStepSizeRegions(config.step_size_regions);
+        run.optimizer->setAmplitudeScale(config.amplitude_scale);
+        run.generation = 0;
+        run.optimizer->loadPopulation(run.yaw_sequences, run.offset_sequences);
+        run.scores.assign(run.yaw_sequences.size(), 0);
+        run.next_candidate = 0;
+        run.pending = 0;
+        run.evaluator_seconds = 0.0;
+        run.evaluations = 0;
+        run.finished = false;
+        runs.push_back(std::move(run));
+    }
+}
+
+void SweepRunner::completeGeneration(int run_index, std::ofstream& results)
+{
+    SweepRun& run = runs[run_index];
+    run.optimizer->setPopulationScores(run.scores);
+    run.generation++;
+
+    const SweepConfig& config = run.config;
+    results << run_index << "," << config.population_amount << "," << config.surviver_amount << "," << config.generations << "," << config.basis_size << ","
+        << config.step_size_regions << "," << config.surrogate_oversampling << "," << config.selection_mode << "," << config.amplitude_scale << ","
+        << config.recombination_rate << "," << config.seed << "," << run.generation << "," << run.optimizer->getBestScore() << ","
+        << run.evaluations << "," << run.evaluator_seconds << "\n";
+
+    if (run.generation >= config.generations)
+    {
+        run.finished = true;
+        std::cout << "Sweep configuration " << run_index << " finished with " << run.optimizer->getBestScore() << std::endl;
+        return;
+    }
+
+    run.optimizer->inflatePopulation();
+    run.optimizer->loadPopulation(run.yaw_sequences, run.offset_sequences);
+    run.scores.assign(run.yaw_sequences.size(), 0);
+    run.next_candidate = 0;
+}
+
+bool SweepRunner::run(const std::string& results_filename)
+{
+    std::ofstream results(results_filename);
+    if (!results.is_open())
+    {
+        std::cerr << "Unable to open sweep results for writing: " << results_filename << std::endl;
+        return false;
+    }
+    results << "config,population_amount,surviver_amount,generations,basis_size,step_size_regions,surrogate_oversampling,selection_mode,"
+        << "amplitude_scale,recombination_rate,seed,generation,best_score,evaluations,evaluator_seconds\n";
+
+    auto start = std::chrono::steady_clock::now();
+    pool.start();
+
+    // Two candidates per worker keep every worker busy while configurations wait for their last scores
+    int max_in_flight = 2 * pool.getWorkerAmount();
+    // Task id to configuration and candidate slot
+    std::unordered_map<int, std::pair<int, int>> in_flight;
+    int next_id = 0;
+    int finished_amount = 0;
+    double busy_seconds = 0.0;
+
+    while (finished_amount < (int)runs.size())
+    {
+        while ((int)in_flight.size() < max_in_flight)
+        {
+            // Fair share: the configuration with the least evaluator time that has work left
+            int chosen = -1;
+            for (int r = 0; r < (int)runs.size(); r++)
+            {
+                const SweepRun& run = runs[r];
+                if (!run.finished && run.next_candidate < (int)run.yaw_sequences.size()
+                    && (chosen < 0 || run.evaluator_seconds < runs[chosen].evaluator_seconds))
+                {
+                    chosen = r;
+                }
+            }
+            if (chosen < 0)
+            {
+                break;
+            }
+
+            SweepRun& run = runs[chosen];
+            int slot = run.next_candidate++;
+            run.pending++;
+            in_flight[next_id] = std::make_pair(chosen, slot);
+            pool.submit({ next_id, run.yaw_sequences[slot], run.offset_sequences[slot] });
+            next_id++;
+        }
+
+        EvaluationResult result;
+        pool.waitForResult(result);
+
+        std::pair<int, int> owner = in_flight[result.id];
+        in_flight.erase(result.id);
+        SweepRun& run = runs[owner.first];
+        run.scores[owner.second] = result.score;
+        run.pending--;
+        run.evaluations++;
+        run.evaluator_seconds += result.seconds;
+        busy_seconds += result.seconds;
+
+        if (run.pending == 0 && run.next_candidate == (int)run.yaw_sequences.size())
+        {
+            completeGeneration(owner.first, results);
+            if (run.finished)
+            {
+                finished_amount++;
+            }
+        }
+    }
+
+    pool.stop();
+    results.close();
+
+    double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Sweep of " << runs.size() << " configurations took " << elapsed_seconds << " s, worker utilization "
+        << busy_seconds / (pool.getWorkerAmount() * elapsed_seconds) * 100.0 << "%" << std::endl;
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <unordered_map>
+
+#include "libs/glm/glm.hpp"
+
+#include "optimizer.h"
+#include "evaluator_pool.h"
+
+// One optimizer configuration of a sweep
+struct SweepConfig
+{
+    int population_amount;
+    int surviver_amount;
+    int generations;
+    int basis_size;
+    int step_size_regions;
+    int surrogate_oversampling;
+    int selection_mode;
+    double amplitude_scale;
+    double recombination_rate;
+    uint64_t seed;
+};
+
+// Reads configurations, one line each, starting from defaults:
+//   population_amount=20 amplitude_scale=0.5               one configuration
+//   grid population_amount=10,20,40 amplitude_scale=0.5,1   every combination
+//   random 20 population_amount=5:40 selection_mode=0,1    uniform samples of ranges and lists
+// Empty lines and lines starting with # are skipped.
+bool loadSweepConfigs(const std::string& filename, const SweepConfig& defaults, std::vector<SweepConfig>& configs);
+
+// Runs many optimizer configurations concurrently in one process over one
+// EvaluatorPool. Every configuration evolves in generations, and while one waits
+// for the last scores of its generation the others keep the workers busy.
+// The next candidate always comes from the configuration that used the least
+// evaluator time so far, so short and long configurations get equal shares.
+class SweepRunner
+{
+    private:
+    struct SweepRun
+    {
+        SweepConfig config;
+        std::unique_ptr<Optimizer> optimizer;
+        int generation;
+
+        std::vector<std::vector<double>> yaw_sequences;
+        std::vector<std::vector<glm::vec3>> offset_sequences;
+        std::vector<int> scores;
+        int next_candidate;
+        int pending;
+
+        double evaluator_seconds;
+        long long evaluations;
+        bool finished;
+    };
+
+    std::vector<SweepRun> runs;
+    EvaluatorPool pool;
+
+    void completeGeneration(int run_index, std::ofstream& results);
+
+    protected:
+    public:
+    SweepRunner(const std::vector<SweepConfig>& configs, const std::vector<double>& root_yaw_sequence, const std::vector<glm::vec3>& root_offset_sequence,
+        int worker_amount, int frame_width, int frame_height, int time_resolution, glm::vec3 anchor);
+    // Writes one row per configuration and generation to results_filename
+    bool run(const std::string& results_filename);
+};
@@ -0,0 +1,243 @@
+#include "telemetry.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+static const char telemetry_magic[8] = { 'S', 'O', 'F', 'A', 'T', 'L', 'M', 'Y' };
+static const uint32_t telemetry_version = 1;
+static const auto drain_interval = std::chrono::milliseconds(100);
+
+struct TelemetryHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+// Threads remember the ring of the logger they used last
+static std::atomic<uint64_t> next_logger_id(1);
+static thread_local uint64_t cached_logger_id = 0;
+static thread_local TelemetryRing* cached_ring = nullptr;
+
+static size_t roundRingCapacity(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+TelemetryRing::TelemetryRing(size_t capacity, uint16_t thread, std::thread::id owner)
+: records(roundRingCapacity(capacity)), mask(roundRingCapacity(capacity) - 1), thread(thread), owner(owner), head(0), tail(0), dropped(0)
+{
+
+}
+
+TelemetryLogger::TelemetryLogger(const std::string& filename, size_t ring_capacity)
+: ring_capacity(ring_capacity), logger_id(next_logger_id.fetch_add(1)), start(std::chrono::steady_clock::now()),
+  stopping(false), dropped_amount(0), written_amount(0)
+{
+    file = fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        std::cerr << "Unable to open telemetry file: " << filename << std::endl;
+        stopping.store(true);
+        return;
+    }
+
+    TelemetryHeader header;
+    memcpy(header.magic, telemetry_magic, sizeof(telemetry_magic));
+    header.version = telemetry_version;
+    header.record_size = sizeof(TelemetryRecord);
+    fwrite(&header, sizeof(header), 1, file);
+
+    writer = std::thread(&TelemetryLogger::writerLoop, this);
+}
+
+TelemetryLogger::~TelemetryLogger()
+{
+    close();
+}
+
+bool TelemetryLogger::isOpen()
+{
+    return file != nullptr;
+}
+
+TelemetryRing* TelemetryLogger::getRing()
+{
+    if (cached_logger_id == logger_id)
+    {
+        return cached_ring;
+    }
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    std::thread::id owner = std::this_thread::get_id();
+    TelemetryRing* ring = nullptr;
+    for (const std::unique_ptr<TelemetryRing>& candidate : rings)
+    {
+        if (candidate->owner == owner)
+        {
+            ring = candidate.get();
+        }
+    }
+    if (!ring)
+    {
+        rings.push_back(std::unique_ptr<TelemetryRing>(new TelemetryRing(ring_capacity, (uint16_t)rings.size(), owner)));
+        ring = rings.back().get();
+    }
+
+    cached_logger_id = logger_id;
+    cached_ring = ring;
+    return ring;
+}
+
+void TelemetryLogger::log(int generation, int individual, int score, double evaluator_seconds, uint16_t flags)
+{
+    if (stopping.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    TelemetryRing* ring = getRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= ring->records.size())
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TelemetryRecord& record = ring->records[head & ring->mask];
+    record.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    record.generation = generation;
+    record.individual = individual;
+    record.score = score;
+    record.evaluator_seconds = (float)evaluator_seconds;
+    record.thread = ring->thread;
+    record.flags = flags;
+    record.reserved = 0;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void TelemetryLogger::drain()
+{
+    std::vector<TelemetryRing*> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        for (const std::unique_ptr<TelemetryRing>& ring : rings)
+        {
+            snapshot.push_back(ring.get());
+        }
+    }
+
+    std::vector<TelemetryRecord> buffer;
+    size_t drop_records = 0;
+    for (TelemetryRing* ring : snapshot)
+    {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail < head; tail++)
+        {
+            buffer.push_back(ring->records[tail & ring->mask]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+
+        uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            TelemetryRecord record = {};
+            record.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            record.score = (int32_t)std::min<uint64_t>(dropped, INT32_MAX);
+            record.thread = ring->thread;
+            record.flags = TELEMETRY_DROPPED;
+            buffer.push_back(record);
+            drop_records++;
+            dropped_amount.fetch_add(dropped, std::memory_order_relaxed);
+        }
+    }
+
+    if (!buffer.empty())
+    {
+        fwrite(buffer.data(), sizeof(TelemetryRecord), buffer.size(), file);
+        fflush(file);
+        written_amount.fetch_add(buffer.size() - drop_records, std::memory_order_relaxed);
+    }
+}
+
+void TelemetryLogger::writerLoop()
+{
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(drain_interval);
+        drain();
+    }
+    // Records logged before stopping was seen are still in the rings
+    drain();
+}
+
+void TelemetryLogger::close()
+{
+    stopping.store(true, std::memory_order_release);
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+    if (file)
+    {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+uint64_t TelemetryLogger::getDroppedAmount()
+{
+    return dropped_amount.load(std::memory_order_relaxed);
+}
+
+uint64_t TelemetryLogger::getWrittenAmount()
+{
+    return written_amount.load(std::memory_order_relaxed);
+}
+
+bool decodeTelemetryFile(const std::string& filename, std::ostream& output)
+{
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile.is_open())
+    {
+        std::cerr << "Unable to open telemetry file: " << filename << std::endl;
+        return false;
+    }
+
+    TelemetryHeader header;
+    if (!infile.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || memcmp(header.magic, telemetry_magic, sizeof(telemetry_magic)) != 0
+        || header.version != telemetry_version || header.record_size != sizeof(TelemetryRecord))
+    {
+        std::cerr << "Not a telemetry file of this version: " << filename << std::endl;
+        return false;
+    }
+
+    output << "seconds,thread,generation,individual,score,evaluator_seconds,cache_hit,dropped\n";
+    uint64_t record_amount = 0;
+    uint64_t dropped_amount = 0;
+    TelemetryRecord record;
+    while (infile.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        output << record.nanoseconds * 1e-9 << "," << record.thread << ",";
+        if (record.flags & TELEMETRY_DROPPED)
+        {
+            output << ",,,,," << record.score << "\n";
+            dropped_amount += record.score;
+            continue;
+        }
+        output << record.generation << "," << record.individual << "," << record.score << "," << record.evaluator_seconds << ","
+            << ((record.flags & TELEMETRY_CACHE_HIT) ? 1 : 0) << ",\n";
+        record_amount++;
+    }
+
+    std::cerr << "Decoded " << record_amount << " records, " << dropped_amount << " dropped" << std::endl;
+    return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+enum TelemetryFlags
+{
+    TELEMETRY_CACHE_HIT = 1,
+    // Not an evaluation, score holds how many records this thread lost to a full ring
+    TELEMETRY_DROPPED = 2
+};
+
+// One fixed size record per evaluation
+struct TelemetryRecord
+{
+    // Since the logger started
+    uint64_t nanoseconds;
+    int32_t generation;
+    int32_t individual;
+    int32_t score;
+    float evaluator_seconds;
+    uint16_t thread;
+    uint16_t flags;
+    uint32_t reserved;
+};
+
+// Single producer single consumer ring, the owning thread pushes and the writer drains
+struct TelemetryRing
+{
+    std::vector<TelemetryRecord> records;
+    size_t mask;
+    uint16_t thread;
+    std::thread::id owner;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+
+    TelemetryRing(size_t capacity, uint16_t thread, std::thread::id owner);
+};
+
+// Evaluation log that costs the evaluating threads a few stores. Every thread
+// that logs gets its own ring on first use and never waits: when its ring is
+// full the record is counted as dropped instead. A background thread drains
+// the rings a few times per second and appends the records, plus a record
+// for every batch of drops, to a binary file that decodeTelemetryFile turns
+// into CSV.
+class TelemetryLogger
+{
+    private:
+    FILE* file;
+    size_t ring_capacity;
+    uint64_t logger_id;
+    std::chrono::steady_clock::time_point start;
+
+    std::mutex rings_mutex;
+    std::vector<std::unique_ptr<TelemetryRing>> rings;
+
+    std::atomic<bool> stopping;
+    std::thread writer;
+    std::atomic<uint64_t> dropped_amount;
+    std::atomic<uint64_t> written_amount;
+
+    TelemetryRing* getRing();
+    void writerLoop();
+    void drain();
+
+    protected:
+    public:
+    // The ring capacity per thread is rounded up to a power of two
+    TelemetryLogger(const std::string& filename, size_t ring_capacity = 1 << 14);
+    ~TelemetryLogger();
+    bool isOpen();
+    void log(int generation, int individual, int score, double evaluator_seconds, uint16_t flags = 0);
+    // Drains what is queued and stops the writer, logging afterwards is dropped
+    void close();
+    uint64_t getDroppedAmount();
+    // Evaluation records written so far, without the drop records
+    uint64_t getWrittenAmount();
+};
+
+// Writes the records of a telemetry file as CSV with a header line
+bool decodeTelemetryFile(const std::string& filename, std::ostream& output);
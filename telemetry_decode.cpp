@@ -0,0 +1,28 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+
+#include "telemetry.h"
+
+// Turns a binary telemetry file into CSV, on stdout unless an output file is given
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " telemetry.bin [output.csv]" << std::endl;
+        return -1;
+    }
+
+    if (argc < 3)
+    {
+        return decodeTelemetryFile(argv[1], std::cout) ? 0 : -1;
+    }
+
+    std::ofstream output(argv[2]);
+    if (!output.is_open())
+    {
+        std::cerr << "Unable to open output file: " << argv[2] << std::endl;
+        return -1;
+    }
+    return decodeTelemetryFile(argv[1], output) ? 0 : -1;
+}
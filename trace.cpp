@@ -0,0 +1,175 @@
+#include "trace.h"
+
+#include <fstream>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+
+std::atomic<bool> tracing_enabled(false);
+
+static std::mutex buffers_mutex;
+static std::vector<std::unique_ptr<TraceBuffer>> buffers;
+static thread_local TraceBuffer* thread_buffer = nullptr;
+static TraceBuffer* gpu_buffer = nullptr;
+static uint64_t gpu_anchor_nanoseconds = 0;
+static uint64_t gpu_anchor_ticks = 0;
+
+// Trace clock and steady clock when tracing was enabled, the second pair is taken by writeTrace
+static uint64_t start_ticks = 0;
+static std::chrono::steady_clock::time_point start_time;
+
+TraceBuffer::TraceBuffer(int thread)
+: chunks(max_chunks), event_amount(0), dropped(0), thread(thread), thread_name("thread " + std::to_string(thread)), gpu_clock(false)
+{
+
+}
+
+static TraceBuffer* getThreadBuffer()
+{
+    if (!thread_buffer)
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer((int)buffers.size())));
+        thread_buffer = buffers.back().get();
+    }
+    return thread_buffer;
+}
+
+void enableTracing()
+{
+    start_time = std::chrono::steady_clock::now();
+    start_ticks = readTraceClock();
+    tracing_enabled.store(true);
+}
+
+void setTraceThreadName(const std::string& name)
+{
+    TraceBuffer* buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffer->thread_name = name;
+}
+
+static void appendTraceEvent(TraceBuffer* buffer, const char* name, uint64_t begin, uint64_t end)
+{
+    size_t index = buffer->event_amount.load(std::memory_order_relaxed);
+    size_t chunk = index / TraceBuffer::chunk_size;
+    if (chunk >= TraceBuffer::max_chunks)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!buffer->chunks[chunk])
+    {
+        buffer->chunks[chunk].reset(new TraceEvent[TraceBuffer::chunk_size]);
+    }
+
+    TraceEvent& event = buffer->chunks[chunk][index % TraceBuffer::chunk_size];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    buffer->event_amount.store(index + 1, std::memory_order_release);
+}
+
+void recordTraceEvent(const char* name, uint64_t begin, uint64_t end)
+{
+    appendTraceEvent(getThreadBuffer(), name, begin, end);
+}
+
+void setGpuTraceClock(uint64_t gpu_nanoseconds, uint64_t ticks)
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    gpu_anchor_nanoseconds = gpu_nanoseconds;
+    gpu_anchor_ticks = ticks;
+    if (!gpu_buffer)
+    {
+        buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer((int)buffers.size())));
+        gpu_buffer = buffers.back().get();
+        gpu_buffer->thread_name = "GPU";
+        gpu_buffer->gpu_clock = true;
+    }
+}
+
+void recordGpuTraceEvent(const char* name, uint64_t begin, uint64_t end)
+{
+    if (gpu_buffer)
+    {
+        appendTraceEvent(gpu_buffer, name, begin, end);
+    }
+}
+
+static void writeJsonString(std::ostream& output, const std::string& text)
+{
+    output << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            output << '\\';
+        }
+        output << c;
+    }
+    output << '"';
+}
+
+bool writeTrace(const std::string& filename)
+{
+    if (!tracing_enabled.load())
+    {
+        return false;
+    }
+
+    std::ofstream output(filename);
+    if (!output.is_open())
+    {
+        std::cerr << "Unable to open trace file: " << filename << std::endl;
+        return false;
+    }
+
+    uint64_t end_ticks = readTraceClock();
+    double elapsed_microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+    double microseconds_per_tick = end_ticks > start_ticks && elapsed_microseconds > 0.0 ? elapsed_microseconds / (end_ticks - start_ticks) : 1e-3;
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    output << std::fixed;
+    output.precision(3);
+    output << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    size_t event_total = 0;
+    uint64_t dropped_total = 0;
+    for (const std::unique_ptr<TraceBuffer>& buffer : buffers)
+    {
+        output << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread << ", \"args\": {\"name\": ";
+        writeJsonString(output, buffer->thread_name);
+        output << "}}";
+        first = false;
+
+        size_t event_amount = buffer->event_amount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < event_amount; i++)
+        {
+            const TraceEvent& event = buffer->chunks[i / TraceBuffer::chunk_size][i % TraceBuffer::chunk_size];
+            double begin = 0.0;
+            double duration = 0.0;
+            if (buffer->gpu_clock)
+            {
+                double anchor = (double)(gpu_anchor_ticks - start_ticks) * microseconds_per_tick;
+                begin = std::max(anchor + ((double)event.begin - (double)gpu_anchor_nanoseconds) * 1e-3, 0.0);
+                duration = event.end > event.begin ? (event.end - event.begin) * 1e-3 : 0.0;
+            }
+            else
+            {
+                // Spans begun before tracing was enabled are clamped to its start
+                begin = event.begin > start_ticks ? (event.begin - start_ticks) * microseconds_per_tick : 0.0;
+                duration = event.end > event.begin ? (event.end - event.begin) * microseconds_per_tick : 0.0;
+            }
+            output << ",\n{\"name\": ";
+            writeJsonString(output, event.name);
+            output << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->thread << ", \"ts\": " << begin << ", \"dur\": " << duration << "}";
+        }
+        event_total += event_amount;
+        dropped_total += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    output << "\n]}\n";
+
+    std::cout << "Trace spans " << event_total << " dropped " << dropped_total << " written to " << filename << std::endl;
+    return (bool)output;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// One finished span, times are in trace clock ticks
+struct TraceEvent
+{
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Spans of one thread. Only the owning thread appends, chunks are never moved,
+// so writeTrace can read the published events while the thread keeps running.
+struct TraceBuffer
+{
+    static const size_t chunk_size = 4096;
+    static const size_t max_chunks = 4096;
+
+    std::vector<std::unique_ptr<TraceEvent[]>> chunks;
+    std::atomic<size_t> event_amount;
+    std::atomic<uint64_t> dropped;
+    int thread;
+    std::string thread_name;
+    // Events hold GPU timestamps in nanoseconds instead of trace clock ticks
+    bool gpu_clock;
+
+    TraceBuffer(int thread);
+};
+
+extern std::atomic<bool> tracing_enabled;
+
+// Time stamp counter where there is one, it is calibrated against the steady clock when the trace is written
+inline uint64_t readTraceClock()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Spans are only recorded after this, until then a span costs one relaxed load
+void enableTracing();
+// Names the calling thread in the trace
+void setTraceThreadName(const std::string& name);
+void recordTraceEvent(const char* name, uint64_t begin, uint64_t end);
+// Ties GPU timestamps to the trace clock, gpu_nanoseconds is the GL_TIMESTAMP read at ticks
+void setGpuTraceClock(uint64_t gpu_nanoseconds, uint64_t ticks);
+// Span on the GPU track from GL_TIMESTAMP values, only the GL thread may record them
+void recordGpuTraceEvent(const char* name, uint64_t begin, uint64_t end);
+// Writes every span recorded so far as Chrome trace JSON, viewable in chrome://tracing and Perfetto
+bool writeTrace(const std::string& filename);
+
+// Records the time between its construction and destruction under name, which must be a string literal
+class TraceSpan
+{
+    private:
+    const char* name;
+    uint64_t begin;
+
+    protected:
+    public:
+    explicit TraceSpan(const char* name)
+    : name(name), begin(0)
+    {
+        if (tracing_enabled.load(std::memory_order_relaxed))
+        {
+            begin = readTraceClock();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (begin != 0)
+        {
+            recordTraceEvent(name, begin, readTraceClock());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
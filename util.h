@@ -1,31 +1,15 @@
 #pragma once
 
+#include <iostream>
 #include <cmath>
 #include <vector>
+#include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <cstring>
 #include <ctime>
 
-inline const char* readShaderFromFile(const std::string& filePath)
-{
-    std::ifstream shaderFile(filePath);
-    if (!shaderFile.is_open())
-    {
-        std::cerr << "Failed to open shader file: " << filePath << std::endl;
-        return "";
-    }
-
-    std::stringstream shaderStream;
-    shaderStream << shaderFile.rdbuf();
-    shaderFile.close();
-
-    std::string shaderSourceStr = shaderStream.str();
-    char* shaderSource = new char[shaderSourceStr.length() + 1];
-    strcpy(shaderSource, shaderSourceStr.c_str());
-
-    return shaderSource;
-}
+#include "libs/glm/glm.hpp"
 
 inline double degrees_to_radians(double degrees)
 {
@@ -67,6 +51,60 @@ inline double normalPDF(double x, double mean, double stddev)
     return exp(-0.5 * pow((x - mean) / stddev, 2)) / (stddev * sqrt(2 * M_PI));
 }
 
+// Gaussian elimination with partial pivoting on a dense row-major n x n system,
+// returns an empty vector if the matrix is singular
+inline std::vector<double> solveLinearSystem(std::vector<double> matrix, std::vector<double> rhs, int n)
+{
+    for (int col = 0; col < n; col++)
+    {
+        int pivot = col;
+        for (int row = col + 1; row < n; row++)
+        {
+            if (std::fabs(matrix[row * n + col]) > std::fabs(matrix[pivot * n + col]))
+            {
+                pivot = row;
+            }
+        }
+        if (matrix[pivot * n + col] == 0.0)
+        {
+            return std::vector<double>();
+        }
+        if (pivot != col)
+        {
+            for (int k = 0; k < n; k++)
+            {
+                std::swap(matrix[pivot * n + k], matrix[col * n + k]);
+            }
+            std::swap(rhs[pivot], rhs[col]);
+        }
+        for (int row = col + 1; row < n; row++)
+        {
+            double factor = matrix[row * n + col] / matrix[col * n + col];
+            if (factor == 0.0)
+            {
+                continue;
+            }
+            for (int k = col; k < n; k++)
+            {
+                matrix[row * n + k] -= factor * matrix[col * n + k];
+            }
+            rhs[row] -= factor * rhs[col];
+        }
+    }
+
+    std::vector<double> solution(n);
+    for (int row = n - 1; row >= 0; row--)
+    {
+        double sum = rhs[row];
+        for (int k = row + 1; k < n; k++)
+        {
+            sum -= matrix[row * n + k] * solution[k];
+        }
+        solution[row] = sum / matrix[row * n + row];
+    }
+    return solution;
+}
+
 inline void writeToLogFile(const std::string& message) {
     // Open the log file in append mode
     std::ofstream logfile("logfile.txt", std::ios_base::app);